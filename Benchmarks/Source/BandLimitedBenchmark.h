@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    BandLimitedBenchmark.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BenchmarkHelpers.h"
+#include "../../Source/BandLimitedOscillator.h"
+
+// The PolyBLEP saw, square and triangle against the naive waveforms (what the old commented out lambdas
+// in PluginProcessor.h would have made) and against the naive waveforms rendered at 8x and brought
+// down with juce::dsp::Oversampling, the usual way of getting rid of the aliasing.
+// Times each one and measures its aliasing at around 5kHz, where a 48k naive saw is already bad
+
+namespace bench
+{
+
+class NaiveShape
+{
+public:
+
+    NaiveShape (BandLimitedOscillator::Waveform shape, double frequency, double sampleRate)
+        : waveform (shape), increment (frequency / sampleRate) {}
+
+    void process (float* dest, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto t = (float) phase;
+
+            if (waveform == BandLimitedOscillator::Waveform::saw)
+                dest[i] = 2.0f * t - 1.0f;
+            else if (waveform == BandLimitedOscillator::Waveform::square)
+                dest[i] = t < 0.5f ? 1.0f : -1.0f;
+            else
+                dest[i] = 1.0f - 4.0f * std::abs (t - 0.5f);
+
+            phase += increment;
+            phase -= std::floor (phase);
+        }
+    }
+
+private:
+
+    BandLimitedOscillator::Waveform waveform;
+    double increment;
+    double phase { 0.0 };
+};
+
+// a naive waveform at 8x the rate through juce's polyphase IIR half band filters.
+// The upsampling pass is wasted (its output is written over) but it's how juce::dsp::Oversampling is driven
+class OversampledShape
+{
+public:
+
+    OversampledShape (BandLimitedOscillator::Waveform shape, double frequency, double sampleRate, int blockSize)
+        : naive (shape, frequency, sampleRate * 8.0),
+          oversampling (1, 3, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true),
+          block (1, blockSize)
+    {
+        oversampling.initProcessing ((size_t) blockSize);
+    }
+
+    void process (float* dest, int numSamples)
+    {
+        juce::dsp::AudioBlock<float> audioBlock (block);
+        auto subBlock = audioBlock.getSubBlock (0, (size_t) numSamples);
+
+        auto upsampled = oversampling.processSamplesUp (subBlock);
+        naive.process (upsampled.getChannelPointer (0), (int) upsampled.getNumSamples());
+        oversampling.processSamplesDown (subBlock);
+
+        std::copy (block.getReadPointer (0), block.getReadPointer (0) + numSamples, dest);
+    }
+
+private:
+
+    NaiveShape naive;
+    juce::dsp::Oversampling<float> oversampling;
+    juce::AudioBuffer<float> block;
+};
+
+inline void runBandLimitedBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int fftOrder = 16;
+    constexpr int fundamentalBin = 6805; // 4983.7 Hz at 48k
+
+    const auto frequency = fundamentalBin * sampleRate / (double) (1 << fftOrder);
+    const auto captureLength = 1 << fftOrder;
+
+    const std::pair<BandLimitedOscillator::Waveform, const char*> shapes[] =
+    {
+        { BandLimitedOscillator::Waveform::saw, "saw" },
+        { BandLimitedOscillator::Waveform::square, "square" },
+        { BandLimitedOscillator::Waveform::triangle, "triangle" }
+    };
+
+    std::vector<float> block (blockSize);
+    std::vector<float> capture ((size_t) captureLength);
+
+    // renders the capture a block at a time after a second of settling, the IIR filters need it
+    auto captureAlias = [&] (auto& generator)
+    {
+        for (int i = 0; i < (int) sampleRate; i += blockSize)
+            generator.process (block.data(), blockSize);
+
+        for (int start = 0; start < captureLength; start += blockSize)
+            generator.process (capture.data() + start, blockSize);
+
+        return juce::String (measureAliasDecibels (capture.data(), fftOrder, fundamentalBin), 1) + " dB";
+    };
+
+    for (auto& [shape, shapeName] : shapes)
+    {
+        auto name = juce::String ("shape/") + shapeName;
+
+        NaiveShape naive (shape, frequency, sampleRate);
+        OversampledShape oversampled (shape, frequency, sampleRate, blockSize);
+
+        BandLimitedOscillator polyBlep;
+        polyBlep.prepare (sampleRate);
+        polyBlep.setFrequency (frequency);
+        polyBlep.setWaveform (shape);
+
+        printResult (name + "/naive", timeNsPerSample ([&] { naive.process (block.data(), blockSize); }, blockSize));
+        printResult (name + "/polyblep", timeNsPerSample ([&] { polyBlep.process (block.data(), blockSize); }, blockSize));
+        printResult (name + "/oversampled-8x", timeNsPerSample ([&] { oversampled.process (block.data(), blockSize); }, blockSize));
+
+        printResult (name + "/naive/alias", captureAlias (naive));
+        printResult (name + "/polyblep/alias", captureAlias (polyBlep));
+        printResult (name + "/oversampled-8x/alias", captureAlias (oversampled));
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    BenchmarkHelpers.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace bench
+{
+
+// Heap allocations made through operator new while countAllocations is set on the calling thread
+// (the global operator new in Main.cpp bumps it). juce::HeapBlock goes straight to malloc, so
+// AudioBuffer/Array growth isn't seen, but Strings, vars, std containers and new/delete all are
+inline std::atomic<juce::int64> allocationCount { 0 };
+inline thread_local bool countAllocations = false;
+
+inline void noteAllocation() noexcept
+{
+    if (countAllocations)
+        allocationCount.fetch_add (1, std::memory_order_relaxed);
+}
+
+// The TSC on x86 (reference cycles at the nominal clock, not turbo), 0 where there isn't one
+inline juce::uint64 readCycleCounter() noexcept
+{
+   #if JUCE_INTEL
+    return (juce::uint64) __rdtsc();
+   #else
+    return 0;
+   #endif
+}
+
+struct Measurement
+{
+    double nsPerSample { 0.0 };
+    double cyclesPerSample { 0.0 };     // 0 if there's no cycle counter
+    double allocationsPerCall { 0.0 };
+};
+
+// Like timeNsPerSample but also counts cycles and allocations, best run for the times and
+// the average over every run for the allocations
+template <typename Fn>
+Measurement measure (Fn&& fn, int numSamples, double minSeconds = 0.25)
+{
+    const auto ticksPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+    auto bestSeconds = std::numeric_limits<double>::max();
+    auto bestCycles = std::numeric_limits<double>::max();
+    double total = 0.0;
+    juce::int64 numCalls = 0;
+
+    fn();
+
+    auto allocationsBefore = allocationCount.load();
+    countAllocations = true;
+
+    while (total < minSeconds)
+    {
+        auto startCycles = readCycleCounter();
+        auto start = juce::Time::getHighResolutionTicks();
+        fn();
+        auto seconds = (double) (juce::Time::getHighResolutionTicks() - start) / ticksPerSecond;
+        auto cycles = (double) (readCycleCounter() - startCycles);
+
+        bestSeconds = juce::jmin (bestSeconds, seconds);
+        bestCycles = juce::jmin (bestCycles, cycles);
+        total += seconds;
+        ++numCalls;
+    }
+
+    countAllocations = false;
+
+    Measurement result;
+    result.nsPerSample = bestSeconds * 1.0e9 / (double) numSamples;
+    result.cyclesPerSample = bestCycles / (double) numSamples;
+    result.allocationsPerCall = (double) (allocationCount.load() - allocationsBefore) / (double) numCalls;
+    return result;
+}
+
+// Runs fn (which renders numSamples samples) until at least minSeconds have passed
+// and returns the best ns per sample over the runs, the best run is the least disturbed one
+template <typename Fn>
+double timeNsPerSample (Fn&& fn, int numSamples, double minSeconds = 0.25)
+{
+    const auto ticksPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+    auto best = std::numeric_limits<double>::max();
+    double total = 0.0;
+
+    fn(); // warm up caches and branch predictors
+
+    while (total < minSeconds)
+    {
+        auto start = juce::Time::getHighResolutionTicks();
+        fn();
+        auto seconds = (double) (juce::Time::getHighResolutionTicks() - start) / ticksPerSecond;
+
+        best = juce::jmin (best, seconds);
+        total += seconds;
+    }
+
+    return best * 1.0e9 / (double) numSamples;
+}
+
+// THD+N of a signal whose fundamental sits exactly on fundamentalBin of a 2^fftOrder FFT,
+// so no window is needed and everything outside that bin is distortion or noise
+inline double measureThdNDecibels (const float* data, int fftOrder, int fundamentalBin)
+{
+    juce::dsp::FFT fft (fftOrder);
+    const auto size = fft.getSize();
+
+    std::vector<float> fftData ((size_t) size * 2, 0.0f);
+    std::copy (data, data + size, fftData.begin());
+    fft.performFrequencyOnlyForwardTransform (fftData.data());
+
+    double fundamental = 0.0;
+    double residual = 0.0;
+
+    for (int bin = 1; bin < size / 2; ++bin)
+    {
+        auto power = (double) fftData[(size_t) bin] * (double) fftData[(size_t) bin];
+
+        if (bin == fundamentalBin)
+            fundamental += power;
+        else
+            residual += power;
+    }
+
+    return 10.0 * std::log10 (juce::jmax (residual, 1.0e-30) / fundamental);
+}
+
+// Aliasing of a periodic waveform whose fundamental sits exactly on fundamentalBin: the power outside the
+// harmonic bins against the power in them. Aliases fold back onto whole bins too, so no window is needed
+inline double measureAliasDecibels (const float* data, int fftOrder, int fundamentalBin)
+{
+    juce::dsp::FFT fft (fftOrder);
+    const auto size = fft.getSize();
+
+    std::vector<float> fftData ((size_t) size * 2, 0.0f);
+    std::copy (data, data + size, fftData.begin());
+    fft.performFrequencyOnlyForwardTransform (fftData.data());
+
+    double harmonics = 0.0;
+    double aliases = 0.0;
+
+    for (int bin = 1; bin < size / 2; ++bin)
+    {
+        auto power = (double) fftData[(size_t) bin] * (double) fftData[(size_t) bin];
+
+        if (bin % fundamentalBin == 0)
+            harmonics += power;
+        else
+            aliases += power;
+    }
+
+    return 10.0 * std::log10 (juce::jmax (aliases, 1.0e-30) / harmonics);
+}
+
+inline void printResult (const juce::String& name, double nsPerSample)
+{
+    std::cout << name.paddedRight (' ', 48) << juce::String (nsPerSample, 3) << " ns/sample" << std::endl;
+}
+
+inline void printResult (const juce::String& name, const juce::String& value)
+{
+    std::cout << name.paddedRight (' ', 48) << value << std::endl;
+}
+
+} // namespace bench
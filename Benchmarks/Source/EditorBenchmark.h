@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    EditorBenchmark.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BenchmarkHelpers.h"
+#include "../../Source/PluginProcessor.h"
+
+// What a full repaint of the editor costs on the message thread, rendered offscreen at 1x and 2x
+// (HiDPI) and at a couple of sizes. The first paint after a resize also draws the cached background,
+// the later ones only blit it, both are reported. SIG_REPAINT_STATS=1 shows the same thing live in a host
+
+namespace bench
+{
+
+inline void runEditorBenchmarks()
+{
+    SIGAudioProcessor processor;
+    processor.setPlayConfigDetails (2, 2, 48000.0, 512);
+    processor.prepareToPlay (48000.0, 512);
+
+    std::unique_ptr<juce::AudioProcessorEditor> editor (processor.createEditor());
+    const auto baseBounds = editor->getLocalBounds();
+
+    for (auto size : { 1.0f, 2.0f })
+    {
+        editor->setSize (juce::roundToInt ((float) baseBounds.getWidth() * size), juce::roundToInt ((float) baseBounds.getHeight() * size));
+
+        for (auto scale : { 1.0f, 2.0f })
+        {
+            auto name = "editor/" + juce::String (editor->getWidth()) + "x" + juce::String (editor->getHeight())
+                          + "/scale=" + juce::String (scale, 0);
+
+            // a resize throws the cached background away, so this one draws it
+            editor->resized();
+
+            auto start = juce::Time::getHighResolutionTicks();
+            editor->createComponentSnapshot (editor->getLocalBounds(), true, scale);
+            auto firstMs = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1000.0;
+
+            auto ms = timeNsPerSample ([&] { editor->createComponentSnapshot (editor->getLocalBounds(), true, scale); }, 1) / 1.0e6;
+
+            printResult (name + "/first-paint", juce::String (firstMs, 3) + " ms");
+            printResult (name + "/repaint", juce::String (ms, 3) + " ms");
+        }
+    }
+
+    editor = nullptr;
+    processor.releaseResources();
+}
+
+} // namespace bench
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    SIG benchmarks - console app that times the dsp outside of a host.
+
+    SIGBenchmarks [--csv <file>] [--json <file>]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SineBenchmark.h"
+#include "PinkNoiseBenchmark.h"
+#include "WhiteNoiseBenchmark.h"
+#include "MultisineBenchmark.h"
+#include "BandLimitedBenchmark.h"
+#include "ProcessorBenchmark.h"
+#include "EditorBenchmark.h"
+
+//==============================================================================
+// counts allocations for bench::measure, see BenchmarkHelpers.h
+void* operator new (std::size_t size)
+{
+    bench::noteAllocation();
+
+    if (auto* ptr = std::malloc (size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* ptr) noexcept                  { std::free (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept     { std::free (ptr); }
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser; // the processor's parameter state needs a message manager
+
+    auto cwd = juce::File::getCurrentWorkingDirectory();
+    auto csvFile = cwd.getChildFile ("processBlock.csv");
+    auto jsonFile = cwd.getChildFile ("processBlock.json");
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        juce::String arg (argv[i]);
+
+        if (arg == "--csv")
+            csvFile = cwd.getChildFile (argv[i + 1]);
+        else if (arg == "--json")
+            jsonFile = cwd.getChildFile (argv[i + 1]);
+    }
+
+    bench::runSineBenchmarks();
+    bench::runPinkNoiseBenchmarks();
+    bench::runWhiteNoiseBenchmarks();
+    bench::runMultisineBenchmarks();
+    bench::runBandLimitedBenchmarks();
+    bench::runDispatchBenchmarks();
+    bench::runEventBenchmarks();
+    bench::runPrecisionBenchmarks();
+    bench::runProgramBenchmarks();
+    bench::runSharedEngineBenchmarks();
+    bench::runCrossfadeBenchmarks();
+    bench::runBlockTimingBenchmarks();
+    bench::runSequencerBenchmarks();
+    bench::runEditorBenchmarks();
+    bench::runProcessBlockSweep (csvFile, jsonFile);
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    MultisineBenchmark.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BenchmarkHelpers.h"
+#include "../../Source/Multisine.h"
+#include "../../Source/SineOscillator.h"
+
+// Multisine loop table against summing one SineOscillator per tone (what stacking SIG instances does),
+// for more and more tones. Also how long building a table takes on the builder thread
+
+namespace bench
+{
+
+inline void runMultisineBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    std::vector<float> block (blockSize);
+    std::vector<float> scratch (blockSize);
+
+    for (auto numTones : { 1, 10, 31, 100 })
+    {
+        juce::Array<Multisine::Tone> tones;
+
+        for (int i = 0; i < numTones; ++i)
+            tones.add ({ 20.0 * std::pow (1000.0, (double) i / juce::jmax (1, numTones - 1)), 1.0f, 0.0 });
+
+        Multisine::setSchroederPhases (tones);
+
+        std::vector<SineOscillator> oscillators ((size_t) numTones);
+
+        for (int i = 0; i < numTones; ++i)
+        {
+            oscillators[(size_t) i].prepare (sampleRate);
+            oscillators[(size_t) i].setFrequency (tones[i].frequency);
+            oscillators[(size_t) i].setPhase (tones[i].phase);
+        }
+
+        auto stackedNs = timeNsPerSample ([&]
+        {
+            juce::FloatVectorOperations::clear (block.data(), blockSize);
+
+            for (auto& osc : oscillators)
+            {
+                osc.process (scratch.data(), blockSize);
+                juce::FloatVectorOperations::add (block.data(), scratch.data(), blockSize);
+            }
+        }, blockSize);
+
+        auto buildStart = juce::Time::getMillisecondCounterHiRes();
+        auto table = Multisine::createTable (tones, sampleRate);
+        auto buildMs = juce::Time::getMillisecondCounterHiRes() - buildStart;
+
+        Multisine multisine;
+        multisine.prepare (sampleRate, std::move (table));
+
+        auto tableNs = timeNsPerSample ([&] { multisine.process (block.data(), blockSize); }, blockSize);
+
+        auto name = "multisine/" + juce::String (numTones) + "-tones";
+        printResult (name + "/stacked-oscillators", stackedNs);
+        printResult (name + "/loop-table", tableNs);
+        printResult (name + "/table-build", juce::String (buildMs, 2) + " ms");
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    PinkNoiseBenchmark.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <thread>
+#include "BenchmarkHelpers.h"
+#include "../../Source/PinkNoise.h"
+
+// The block Voss-McCartney PinkNoise against the old 5 row PinkNumber, kept here as the reference.
+// Also many generators on many threads at once, like lots of SIG instances in a host, where the
+// old one's rand() calls all go through the same lock
+
+namespace bench
+{
+
+class LegacyPinkNumber
+{
+public:
+
+    LegacyPinkNumber()
+    {
+        for (int i = 0; i < 5; i++)
+            white_values[i] = rand() % (range / 5);
+    }
+
+    int GetNextValue()
+    {
+        int last_key = key;
+        unsigned int sum = 0;
+
+        key++;
+        if (key > max_key)
+            key = 0;
+
+        int diff = last_key ^ key;
+
+        for (int i = 0; i < 5; i++)
+        {
+            if (diff & (1 << i))
+                white_values[i] = rand() % (range / 5);
+            sum += white_values[i];
+        }
+        return sum;
+    }
+
+    void process (float* dest, int numSamples)
+    {
+        for (int sample = 0; sample < numSamples; ++sample)
+            dest[sample] = GetNextValue() * 0.00849f;
+    }
+
+private:
+
+    int max_key = 0x1f;
+    int key = 0;
+    unsigned int white_values[5];
+    unsigned int range = 128;
+};
+
+// Total throughput of numThreads generators each rendering on its own thread, in millions of samples a second
+template <typename Generator>
+double multiThreadThroughput (int numThreads, int samplesPerThread)
+{
+    std::vector<Generator> generators ((size_t) numThreads);
+    std::vector<std::thread> threads;
+    std::atomic<bool> go { false };
+
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back ([&, t]
+        {
+            std::vector<float> block (512);
+
+            while (! go.load())
+                std::this_thread::yield();
+
+            for (int done = 0; done < samplesPerThread; done += (int) block.size())
+            {
+                generators[(size_t) t].process (block.data(), (int) block.size());
+            }
+        });
+    }
+
+    auto start = juce::Time::getHighResolutionTicks();
+    go = true;
+
+    for (auto& thread : threads)
+        thread.join();
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+    return (double) numThreads * (double) samplesPerThread / seconds / 1.0e6;
+}
+
+inline void runPinkNoiseBenchmarks()
+{
+    constexpr int blockSize = 512;
+    std::vector<float> block (blockSize);
+
+    LegacyPinkNumber legacyPink;
+    PinkNoise pink;
+
+    printResult ("pink/legacy-5-rows", timeNsPerSample ([&] { legacyPink.process (block.data(), blockSize); }, blockSize));
+    printResult ("pink/voss-16-rows", timeNsPerSample ([&] { pink.process (block.data(), blockSize); }, blockSize));
+
+    pink.setNumRows (24);
+    printResult ("pink/voss-24-rows", timeNsPerSample ([&] { pink.process (block.data(), blockSize); }, blockSize));
+
+    // a seek costs one Philox block per row, spread over the block it's followed by
+    juce::int64 position = 0;
+    pink.setNumRows (16);
+    printResult ("pink/seek-every-block", timeNsPerSample ([&]
+    {
+        pink.seek (position += 1000003);
+        pink.process (block.data(), blockSize);
+    }, blockSize));
+
+    constexpr int samplesPerThread = 1 << 22;
+    const auto maxThreads = juce::jmax (1, (int) std::thread::hardware_concurrency());
+
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        auto legacy = multiThreadThroughput<LegacyPinkNumber> (numThreads, samplesPerThread);
+        auto perInstance = multiThreadThroughput<PinkNoise> (numThreads, samplesPerThread);
+
+        printResult ("pink/rand/threads=" + juce::String (numThreads), juce::String (legacy, 1) + " Msamples/s");
+        printResult ("pink/philox/threads=" + juce::String (numThreads), juce::String (perInstance, 1) + " Msamples/s");
+    }
+}
+
+} // namespace bench
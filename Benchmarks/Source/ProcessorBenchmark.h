@@ -0,0 +1,488 @@
+/*
+  ==============================================================================
+
+    ProcessorBenchmark.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BenchmarkHelpers.h"
+#include "../../Source/PluginProcessor.h"
+
+// SIGAudioProcessor::processBlock for every signal type and routing.
+// runDispatchBenchmarks compares it with the render loop from before the kernels were specialised
+// (a switch on the signal per chunk and a routing mask test per channel) driving the same generators.
+// runProcessBlockSweep times every signal x routing x channel count (up to 64) x sample rate x block size and
+// writes the results as CSV and JSON so runs can be diffed between releases.
+// runEventBenchmarks is the cost of splitting a block at MIDI events against the no event fast path,
+// runPrecisionBenchmarks is float against double processBlock for every signal,
+// runProgramBenchmarks is a program change every block against none and the cost of saving and recalling state,
+// runSharedEngineBenchmarks is a host cycle of many instances playing the same sine with and without the shared engine,
+// runCrossfadeBenchmarks is a signal change every block (so every block is a crossfade) against no changes,
+// runBlockTimingBenchmarks is what the processBlock timing adds to every block,
+// runSequencerBenchmarks is the sequencer stepping every 10ms against no sequencer, and checks a sequence renders
+// the same with different block sizes
+
+namespace bench
+{
+
+inline void setParameter (SIGAudioProcessor& processor, const juce::String& paramID, float value)
+{
+    auto* param = processor.treeState.getParameter (paramID);
+    param->setValueNotifyingHost (param->convertTo0to1 (value));
+}
+
+class RuntimeDispatchRenderer
+{
+public:
+
+    void prepare (double sampleRate, int numChannels, int blockSize)
+    {
+        osc.prepare (sampleRate);
+        osc.setFrequency (1000.0);
+        whiteNoise.prepare (numChannels, 1234);
+        signal.setSize (1, blockSize);
+    }
+
+    void render (juce::AudioBuffer<float>& buffer, int signalType, int routingChoice)
+    {
+        const std::uint64_t masks[] = { 0x1, ~std::uint64_t (0), 0x2 };
+        auto mask = masks[routingChoice];
+        auto numSamples = buffer.getNumSamples();
+        auto* mono = signal.getWritePointer (0);
+
+        switch (signalType)
+        {
+            case 0: osc.process (mono, numSamples); break;
+            case 2: pink.process (mono, numSamples); break;
+            default: break;
+        }
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            if (((mask >> channel) & 1) == 0)
+                buffer.clear (channel, 0, numSamples);
+            else if (signalType == 1)
+                whiteNoise.process (channel, buffer.getWritePointer (channel), numSamples);
+            else
+                buffer.copyFrom (channel, 0, signal, 0, 0, numSamples);
+
+            juce::FloatVectorOperations::multiply (buffer.getWritePointer (channel), 0.1f, numSamples);
+        }
+    }
+
+private:
+
+    SineOscillator osc;
+    WhiteNoiseBank whiteNoise;
+    PinkNoise pink;
+    juce::AudioBuffer<float> signal;
+};
+
+inline void runDispatchBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    const char* signalNames[] = { "sine", "white", "pink" };
+    const char* routingNames[] = { "l", "lr", "r" };
+
+    juce::MidiBuffer midi;
+
+    for (int numChannels = 1; numChannels <= 2; ++numChannels)
+    {
+        SIGAudioProcessor processor;
+        processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        RuntimeDispatchRenderer reference;
+        reference.prepare (sampleRate, numChannels, blockSize);
+
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+
+        for (int signalType = 0; signalType < 3; ++signalType)
+        {
+            for (int routing = 0; routing < 3; ++routing)
+            {
+                setParameter (processor, "signal", (float) signalType);
+                setParameter (processor, "routing", (float) routing);
+
+                auto kernelNs = timeNsPerSample ([&] { processor.processBlock (buffer, midi); }, blockSize);
+                auto referenceNs = timeNsPerSample ([&] { reference.render (buffer, signalType, routing); }, blockSize);
+
+                auto name = "processBlock/" + juce::String (signalNames[signalType]) + "/" + routingNames[routing]
+                              + "/" + juce::String (numChannels) + "ch";
+
+                printResult (name, kernelNs);
+                printResult (name + "/runtime-dispatch", referenceNs);
+                printResult (name + "/speedup", juce::String (referenceNs / kernelNs, 2) + "x");
+            }
+        }
+
+        processor.releaseResources();
+    }
+}
+
+inline void runEventBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    SIGAudioProcessor processor;
+    processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+    setParameter (processor, "signal", 0.0f);
+    setParameter (processor, "midi", 1.0f);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+
+    for (int numEvents : { 0, 1, 8, 64 })
+    {
+        juce::MidiBuffer midi;
+
+        for (int i = 0; i < numEvents; ++i)
+            midi.addEvent (juce::MidiMessage::noteOn (1, 60 + i % 24, (juce::uint8) 100), i * blockSize / numEvents);
+
+        auto ns = timeNsPerSample ([&] { processor.processBlock (buffer, midi); }, blockSize);
+
+        printResult ("processBlock/sine/lr/2ch/events=" + juce::String (numEvents), ns);
+    }
+
+    processor.releaseResources();
+}
+
+inline void runPrecisionBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    const char* signalNames[] = { "sine", "white", "pink", "sweep", "multisine", "saw", "square", "triangle" };
+
+    juce::MidiBuffer midi;
+    juce::AudioBuffer<float> floatBuffer (2, blockSize);
+    juce::AudioBuffer<double> doubleBuffer (2, blockSize);
+
+    for (int signalType = 0; signalType < 8; ++signalType)
+    {
+        double ns[2] {};
+
+        for (auto precision : { juce::AudioProcessor::singlePrecision, juce::AudioProcessor::doublePrecision })
+        {
+            SIGAudioProcessor processor;
+            processor.setProcessingPrecision (precision);
+            processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+            processor.prepareToPlay (sampleRate, blockSize);
+            setParameter (processor, "signal", (float) signalType);
+            setParameter (processor, "sineCache", 0.0f); // the live polynomial, the loop is the same copy either way
+
+            if (precision == juce::AudioProcessor::singlePrecision)
+                ns[0] = timeNsPerSample ([&] { processor.processBlock (floatBuffer, midi); }, blockSize);
+            else
+                ns[1] = timeNsPerSample ([&] { processor.processBlock (doubleBuffer, midi); }, blockSize);
+
+            processor.releaseResources();
+        }
+
+        auto name = "processBlock/" + juce::String (signalNames[signalType]) + "/lr/2ch";
+
+        printResult (name + "/float", ns[0]);
+        printResult (name + "/double", ns[1]);
+        printResult (name + "/double-cost", juce::String (ns[1] / ns[0], 2) + "x");
+    }
+}
+
+inline void runProgramBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    SIGAudioProcessor processor;
+    processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    juce::MidiBuffer midi;
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    int program = 0;
+
+    auto steady = measure ([&] { processor.processBlock (buffer, midi); }, blockSize);
+    auto switching = measure ([&]
+    {
+        processor.setCurrentProgram (program++ % processor.getNumPrograms());
+        processor.processBlock (buffer, midi);
+    }, blockSize);
+
+    printResult ("processBlock/no-program-change", steady.nsPerSample);
+    printResult ("processBlock/program-change-every-block", switching.nsPerSample);
+    printResult ("processBlock/program-change-every-block/allocations", juce::String (switching.allocationsPerCall, 2) + " per block");
+
+    juce::MemoryBlock state;
+    processor.getStateInformation (state);
+
+    juce::MemoryBlock treeState;
+    {
+        juce::MemoryOutputStream stream (treeState, false);
+        processor.treeState.state.writeToStream (stream);
+    }
+
+    auto time = [] (auto&& fn)
+    {
+        auto start = juce::Time::getHighResolutionTicks();
+        fn();
+        return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e6;
+    };
+
+    auto binaryMicroseconds = time ([&] { processor.setStateInformation (state.getData(), (int) state.getSize()); });
+    auto treeMicroseconds = time ([&] { processor.setStateInformation (treeState.getData(), (int) treeState.getSize()); });
+
+    printResult ("state/binary", juce::String ((int) state.getSize()) + " bytes, recall " + juce::String (binaryMicroseconds, 1) + " us");
+    printResult ("state/valuetree", juce::String ((int) treeState.getSize()) + " bytes, recall " + juce::String (treeMicroseconds, 1) + " us");
+
+    processor.releaseResources();
+}
+
+inline void runSharedEngineBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    juce::MidiBuffer midi;
+    juce::AudioBuffer<float> buffer (2, blockSize);
+
+    for (int numInstances : { 1, 8, 64 })
+    {
+        std::vector<std::unique_ptr<SIGAudioProcessor>> processors;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            processors.push_back (std::make_unique<SIGAudioProcessor>());
+            auto& processor = *processors.back();
+            processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+            processor.prepareToPlay (sampleRate, blockSize);
+            setParameter (processor, "bypass", 1.0f);
+            setParameter (processor, "signal", 0.0f);
+            setParameter (processor, "freq", 1000.0f);
+            setParameter (processor, "sineCache", 0.0f);
+        }
+
+        auto hostCycle = [&]
+        {
+            for (auto& processor : processors)
+                processor->processBlock (buffer, midi);
+        };
+
+        auto name = "host-cycle/sine/" + juce::String (numInstances) + "-instances";
+
+        printResult (name + "/own", timeNsPerSample (hostCycle, blockSize));
+
+        for (auto& processor : processors)
+            setParameter (*processor, "shared", 1.0f);
+
+        printResult (name + "/shared", timeNsPerSample (hostCycle, blockSize));
+
+        for (auto& processor : processors)
+            processor->releaseResources();
+    }
+}
+
+inline void runCrossfadeBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    SIGAudioProcessor processor;
+    processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+    setParameter (processor, "bypass", 1.0f);
+
+    juce::MidiBuffer midi;
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    int block = 0;
+
+    auto steady = measure ([&] { processor.processBlock (buffer, midi); }, blockSize);
+    auto fading = measure ([&]
+    {
+        // sine and pink take turns so a fade starts at the top of every block
+        setParameter (processor, "signal", (float) (2 * (block++ % 2)));
+        processor.processBlock (buffer, midi);
+    }, blockSize);
+
+    printResult ("processBlock/no-change", steady.nsPerSample);
+    printResult ("processBlock/crossfade-every-block", fading.nsPerSample);
+    printResult ("processBlock/crossfade-every-block/allocations", juce::String (fading.allocationsPerCall, 2) + " per block");
+
+    processor.releaseResources();
+}
+
+inline void runBlockTimingBenchmarks()
+{
+   #if SIG_BLOCK_TIMING
+    BlockTimer timer;
+    timer.prepare (48000.0, 512);
+
+    // an empty block, so it's only the two counter reads and the histogram update
+    auto nsPerBlock = timeNsPerSample ([&] { const BlockTimer::ScopedBlock timing (timer, 512); }, 1);
+
+    printResult ("block-timing/overhead-per-block", juce::String (nsPerBlock, 1) + " ns");
+   #else
+    printResult ("block-timing/overhead-per-block", "built with SIG_BLOCK_TIMING=0");
+   #endif
+}
+
+inline void runSequencerBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    TestSequence shortSteps;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        TestSequence::Step step;
+        step.signalType = i % 3 == 2 ? 2 : 0;   // sine, sine, pink
+        step.frequency = 100.0f * (float) (i + 1);
+        step.on = i != 7;
+        step.seconds = TestSequence::minStepSeconds;
+        shortSteps.steps.push_back (step);
+    }
+
+    shortSteps.loop = true;
+
+    juce::MidiBuffer midi;
+
+    {
+        SIGAudioProcessor processor;
+        processor.setTestSequence (shortSteps);
+        processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+
+        printResult ("processBlock/no-sequencer", timeNsPerSample ([&] { processor.processBlock (buffer, midi); }, blockSize));
+        setParameter (processor, "sequencer", 1.0f);
+
+        auto stepping = measure ([&] { processor.processBlock (buffer, midi); }, blockSize);
+        printResult ("processBlock/sequencer-10ms-steps", stepping.nsPerSample);
+        printResult ("processBlock/sequencer-10ms-steps/allocations", juce::String (stepping.allocationsPerCall, 2) + " per block");
+
+        processor.releaseResources();
+    }
+
+    // two seconds of the list at two block sizes, the steps have to land on the same samples
+    auto render = [&] (int renderBlockSize)
+    {
+        SIGAudioProcessor processor;
+        processor.setNoiseSeed (1);
+        processor.setTestSequence (shortSteps);
+        setParameter (processor, "sineCache", 0.0f);
+        setParameter (processor, "sequencer", 1.0f);
+        processor.setPlayConfigDetails (2, 2, sampleRate, renderBlockSize);
+        processor.prepareToPlay (sampleRate, renderBlockSize);
+
+        juce::AudioBuffer<float> output (2, (int) sampleRate * 2);
+
+        for (int start = 0; start < output.getNumSamples(); start += renderBlockSize)
+        {
+            auto num = juce::jmin (renderBlockSize, output.getNumSamples() - start);
+            juce::AudioBuffer<float> block (output.getArrayOfWritePointers(), 2, start, num);
+            block.clear();
+            processor.processBlock (block, midi);
+        }
+
+        processor.releaseResources();
+        return output;
+    };
+
+    auto small = render (64);
+    auto large = render (1000);
+    auto maxDifference = 0.0f;
+
+    for (int channel = 0; channel < 2; ++channel)
+        for (int i = 0; i < small.getNumSamples(); ++i)
+            maxDifference = juce::jmax (maxDifference, std::abs (small.getSample (channel, i) - large.getSample (channel, i)));
+
+    printResult ("sequencer/block-size-64-vs-1000/max-difference", juce::String (maxDifference, 9));
+}
+
+inline void runProcessBlockSweep (const juce::File& csvFile, const juce::File& jsonFile)
+{
+    const char* signalNames[] = { "sine", "white", "pink", "sweep", "multisine", "saw", "square", "triangle" };
+    const char* routingNames[] = { "l", "lr", "r", "custom", "walk" };
+    const int channelCounts[] = { 1, 2, 8, 64 };
+    const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0, 352800.0, 384000.0 };
+
+    juce::String csv ("signal,routing,channels,sample_rate,block_size,ns_per_sample,cycles_per_sample,allocations_per_block\n");
+    juce::Array<juce::var> rows;
+    juce::MidiBuffer midi;
+
+    for (auto numChannels : channelCounts)
+    {
+        SIGAudioProcessor processor;
+
+        // every other channel on for custom, walk steps through them
+        for (int channel = 0; channel < SIGAudioProcessor::maxChannels; ++channel)
+            setParameter (processor, "ch" + juce::String (channel + 1), (float) (channel % 2 == 0));
+
+        for (auto sampleRate : sampleRates)
+        {
+            for (int blockSize = 16; blockSize <= 4096; blockSize *= 2)
+            {
+                processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+                processor.prepareToPlay (sampleRate, blockSize);
+
+                juce::AudioBuffer<float> buffer (numChannels, blockSize);
+
+                for (int signalType = 0; signalType < 8; ++signalType)
+                {
+                    for (int routing = 0; routing < 5; ++routing)
+                    {
+                        setParameter (processor, "signal", (float) signalType);
+                        setParameter (processor, "routing", (float) routing);
+
+                        // short runs, there are thousands of them
+                        auto result = measure ([&] { processor.processBlock (buffer, midi); }, blockSize, 0.02);
+
+                        csv << signalNames[signalType] << "," << routingNames[routing] << "," << numChannels << ","
+                            << (int) sampleRate << "," << blockSize << "," << juce::String (result.nsPerSample, 4) << ","
+                            << juce::String (result.cyclesPerSample, 3) << "," << juce::String (result.allocationsPerCall, 3) << "\n";
+
+                        auto* row = new juce::DynamicObject();
+                        row->setProperty ("signal", signalNames[signalType]);
+                        row->setProperty ("routing", routingNames[routing]);
+                        row->setProperty ("channels", numChannels);
+                        row->setProperty ("sampleRate", (int) sampleRate);
+                        row->setProperty ("blockSize", blockSize);
+                        row->setProperty ("nsPerSample", result.nsPerSample);
+                        row->setProperty ("cyclesPerSample", result.cyclesPerSample);
+                        row->setProperty ("allocationsPerBlock", result.allocationsPerCall);
+                        rows.add (juce::var (row));
+
+                        if (result.allocationsPerCall > 0.0)
+                            printResult ("processBlock/" + juce::String (signalNames[signalType]) + "/" + routingNames[routing]
+                                           + "/" + juce::String (numChannels) + "ch/" + juce::String ((int) sampleRate)
+                                           + "/" + juce::String (blockSize),
+                                         "ALLOCATES " + juce::String (result.allocationsPerCall, 2) + " per block");
+                    }
+                }
+
+                processor.releaseResources();
+            }
+        }
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+    report->setProperty ("juce", juce::SystemStats::getJUCEVersion());
+    report->setProperty ("date", juce::Time::getCurrentTime().toISO8601 (true));
+    report->setProperty ("results", rows);
+
+    csvFile.replaceWithText (csv);
+    jsonFile.replaceWithText (juce::JSON::toString (juce::var (report)));
+
+    printResult ("processBlock/sweep", juce::String (rows.size()) + " results in " + csvFile.getFullPathName()
+                                          + " and " + jsonFile.getFileName());
+}
+
+} // namespace bench
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    SineBenchmark.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BenchmarkHelpers.h"
+#include "../../Source/CachedSineOscillator.h"
+#include "../../Source/SineSweep.h"
+
+// SineOscillator against the juce::dsp::Oscillator setup the plugin used before
+// (std::sin lambda, 200 point lookup table, stereo block), the cached loop a steady tone ends up on,
+// and what the analytic sweep phase costs
+
+namespace bench
+{
+
+inline void runSineBenchmarks()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int fftOrder = 16;
+    constexpr int fundamentalBin = 1361; // 996.8 Hz at 48k, lands exactly on a bin
+
+    const auto frequency = fundamentalBin * sampleRate / (double) (1 << fftOrder);
+
+    juce::dsp::Oscillator<float> lookupOsc { [](float x) { return std::sin (x); }, 200 };
+    lookupOsc.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+    lookupOsc.setFrequency ((float) frequency, true);
+
+    SineOscillator sineOsc;
+    sineOsc.prepare (sampleRate);
+    sineOsc.setFrequency (frequency);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+
+    auto lookupNs = timeNsPerSample ([&]
+    {
+        juce::dsp::AudioBlock<float> block (buffer);
+        lookupOsc.process (juce::dsp::ProcessContextReplacing<float> (block));
+    }, blockSize);
+
+    auto engineNs = timeNsPerSample ([&]
+    {
+        sineOsc.process (buffer.getWritePointer (0), blockSize);
+        buffer.copyFrom (1, 0, buffer, 0, 0, blockSize);
+    }, blockSize);
+
+    // let the loop get built and crossfaded in before timing it
+    juce::TimeSliceThread builderThread ("bench table builder");
+    builderThread.startThread();
+
+    CachedSineOscillator cachedOsc;
+    CachedSineBuilder cachedBuilder (cachedOsc, builderThread);
+    cachedOsc.prepare (sampleRate, blockSize);
+    cachedOsc.setFrequency (frequency);
+
+    for (int i = 0; i < 10000 && ! cachedOsc.isPlayingLoop(); ++i)
+    {
+        cachedOsc.process (buffer.getWritePointer (0), blockSize);
+        juce::Thread::sleep (1);
+    }
+
+    auto cachedNs = timeNsPerSample ([&]
+    {
+        cachedOsc.process (buffer.getWritePointer (0), blockSize);
+        buffer.copyFrom (1, 0, buffer, 0, 0, blockSize);
+    }, blockSize);
+
+    printResult ("sine/juce-oscillator-lut200/stereo", lookupNs);
+    printResult ("sine/sine-oscillator/stereo", engineNs);
+    printResult ("sine/cached-loop/stereo", cachedOsc.isPlayingLoop() ? juce::String (cachedNs, 3) + " ns/sample" : juce::String ("no loop"));
+    printResult ("sine/speedup", juce::String (lookupNs / engineNs, 2) + "x");
+
+    // THD+N on one channel, the tone is exactly periodic in the FFT length
+    juce::AudioBuffer<float> capture (1, 1 << fftOrder);
+
+    lookupOsc.reset();
+    juce::dsp::AudioBlock<float> captureBlock (capture);
+    lookupOsc.process (juce::dsp::ProcessContextReplacing<float> (captureBlock));
+
+    printResult ("sine/juce-oscillator-lut200/thd+n",
+                 juce::String (measureThdNDecibels (capture.getReadPointer (0), fftOrder, fundamentalBin), 1) + " dB");
+
+    sineOsc.reset();
+    sineOsc.process (capture.getWritePointer (0), capture.getNumSamples());
+
+    printResult ("sine/sine-oscillator/thd+n",
+                 juce::String (measureThdNDecibels (capture.getReadPointer (0), fftOrder, fundamentalBin), 1) + " dB");
+
+    SineSweep sweep;
+    sweep.prepare (sampleRate);
+
+    SineSweep::Parameters sweepParameters;
+    sweepParameters.seconds = 60.0;
+    sweepParameters.repeat = true;
+
+    for (auto mode : { SineSweep::Mode::logarithmic, SineSweep::Mode::linear })
+    {
+        sweepParameters.mode = mode;
+        sweep.setParameters (sweepParameters);
+
+        auto name = juce::String ("sine/sweep-") + (mode == SineSweep::Mode::logarithmic ? "log" : "linear");
+        printResult (name, timeNsPerSample ([&] { sweep.process (buffer.getWritePointer (0), blockSize); }, blockSize));
+    }
+}
+
+} // namespace bench
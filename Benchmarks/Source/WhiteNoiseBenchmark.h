@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    WhiteNoiseBenchmark.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BenchmarkHelpers.h"
+#include "../../Source/WhiteNoise.h"
+
+// Stereo white noise: the old juce::Random::nextFloat per sample path against WhiteNoiseBank.
+// ns per sample doesn't depend on the rate, so each rate is reported as the share of one core
+// needed to run in real time
+
+namespace bench
+{
+
+inline void runWhiteNoiseBenchmarks()
+{
+    constexpr int numChannels = 2;
+    constexpr int blockSize = 512;
+
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+
+    juce::Random random;
+    WhiteNoiseBank bank;
+    bank.prepare (numChannels, 1234);
+
+    auto renderLegacy = [&]
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* channelData = buffer.getWritePointer (channel);
+
+            for (int sample = 0; sample < blockSize; ++sample)
+                channelData[sample] = random.nextFloat();
+        }
+    };
+
+    auto renderBank = [&]
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            bank.process (channel, buffer.getWritePointer (channel), blockSize);
+    };
+
+    auto legacyNs = timeNsPerSample (renderLegacy, blockSize * numChannels);
+
+    bank.setDistribution (WhiteNoiseBank::Distribution::uniform);
+    auto uniformNs = timeNsPerSample (renderBank, blockSize * numChannels);
+
+    bank.setDistribution (WhiteNoiseBank::Distribution::gaussian);
+    auto gaussianNs = timeNsPerSample (renderBank, blockSize * numChannels);
+
+    printResult ("white/juce-random", legacyNs);
+    printResult ("white/bank-uniform", uniformNs);
+    printResult ("white/bank-gaussian", gaussianNs);
+
+    for (auto sampleRate : { 48000.0, 96000.0, 192000.0 })
+    {
+        auto coreShare = [sampleRate] (double nsPerSample)
+        {
+            return juce::String (nsPerSample * sampleRate * numChannels * 1.0e-9 * 100.0, 4) + " % of a core";
+        };
+
+        auto rate = "/" + juce::String ((int) (sampleRate / 1000.0)) + "k-stereo";
+
+        printResult ("white/juce-random" + rate, coreShare (legacyNs));
+        printResult ("white/bank-uniform" + rate, coreShare (uniformNs));
+        printResult ("white/bank-gaussian" + rate, coreShare (gaussianNs));
+    }
+}
+
+} // namespace bench
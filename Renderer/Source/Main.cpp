@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    SIG renderer - console app that renders SIG's signals offline to WAV/FLAC.
+
+    SIGRenderer <job list> [--out <folder>] [--threads <n>]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser; // the processor's parameter state needs a message manager
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    if (args.isEmpty())
+    {
+        std::cout << "usage: SIGRenderer <job list> [--out <folder>] [--threads <n>]" << std::endl;
+        return 1;
+    }
+
+    auto cwd = juce::File::getCurrentWorkingDirectory();
+    auto jobFile = cwd.getChildFile (args[0]);
+    auto outputFolder = jobFile.getParentDirectory();
+    auto numThreads = juce::SystemStats::getNumCpus();
+
+    for (int i = 1; i + 1 < args.size(); i += 2)
+    {
+        if (args[i] == "--out")
+            outputFolder = cwd.getChildFile (args[i + 1]);
+        else if (args[i] == "--threads")
+            numThreads = juce::jmax (1, args[i + 1].getIntValue());
+    }
+
+    if (! jobFile.existsAsFile())
+    {
+        std::cout << "can't find " << jobFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // one job per line, blank lines and # comments are skipped
+    juce::Array<render::RenderJob> jobs;
+    juce::StringArray lines;
+    jobFile.readLines (lines);
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        auto line = lines[i].upToFirstOccurrenceOf ("#", false, false).trim();
+
+        if (line.isEmpty())
+            continue;
+
+        render::RenderJob job;
+        auto result = render::RenderJob::parse (line, outputFolder, job);
+
+        if (result.failed())
+        {
+            std::cout << jobFile.getFileName() << ":" << (i + 1) << ": " << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        jobs.add (job);
+    }
+
+    render::OfflineRenderer renderer (jobs, numThreads);
+
+    std::cout << "rendering " << jobs.size() << " files (" << renderer.getNumPieces() << " pieces) on "
+              << renderer.getNumThreads() << " threads" << std::endl;
+
+    auto numFailed = renderer.run();
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,379 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <condition_variable>
+#include <mutex>
+#include "RenderJob.h"
+#include "../../Source/PluginProcessor.h"
+
+// Renders a job list with one worker thread per core. Each worker owns a SIGAudioProcessor and one chunk
+// buffer and takes the next piece of work off the list when it's done with the last, so memory is the same
+// for a ten second file as for a ten hour one. The processors are created and destroyed on the main thread
+// (the parameter state has a timer) but only ever process on their worker.
+// Most jobs are one piece, rendered and written a chunk at a time. White and pink noise jobs longer than a
+// worker's buffer are cut into pieces that fill it: every worker renders a piece starting from its own sample
+// (SIGAudioProcessor::seekNoise) and the pieces are written in order, each waiting for the one before.
+// The noise is counter based, so a file rendered in pieces is bit for bit the same as one rendered in one go
+
+namespace render
+{
+
+class OfflineRenderer
+{
+public:
+
+    static constexpr int chunkSize = 1 << 16; // samples per processBlock and per write to disk
+    static constexpr int bufferSize = SIGAudioProcessor::maxChannels * chunkSize; // samples a worker's buffer holds
+
+    OfflineRenderer (const juce::Array<RenderJob>& jobsToRender, int numThreads)
+        : jobs (jobsToRender), progress ((size_t) jobsToRender.size())
+    {
+        results.insertMultiple (0, juce::Result::ok(), jobs.size());
+
+        for (int jobIndex = 0; jobIndex < jobs.size(); ++jobIndex)
+        {
+            auto& job = jobs.getReference (jobIndex);
+            auto length = job.getLengthInSamples();
+            auto pieceLength = job.canBeSplit() ? getPieceLength (job) : length;
+            juce::int64 start = 0;
+            int index = 0;
+
+            do
+            {
+                pieces.push_back ({ jobIndex, index++, start, juce::jmin (pieceLength, length - start) });
+                start += pieceLength;
+            }
+            while (start < length);
+
+            progress[(size_t) jobIndex].numPieces = index;
+        }
+
+        // there's no use for more threads than pieces
+        numThreads = juce::jmin (numThreads, (int) pieces.size());
+
+        for (int i = 0; i < juce::jmax (1, numThreads); ++i)
+            workers.add (new Worker (*this, i));
+    }
+
+    int getNumThreads() const noexcept { return workers.size(); }
+    int getNumPieces() const noexcept { return (int) pieces.size(); }
+
+    // blocks until every job has been rendered, returns the number that failed
+    int run()
+    {
+        for (auto* worker : workers)
+            worker->startThread();
+
+        for (auto* worker : workers)
+            worker->waitForThreadToExit (-1);
+
+        int numFailed = 0;
+
+        for (auto& result : results)
+            if (result.failed())
+                ++numFailed;
+
+        return numFailed;
+    }
+
+    // opens a WAV or FLAC writer (picked by the file extension), replacing any file that's there
+    static juce::Result createWriter (const juce::File& file, double sampleRate, int numChannels, int bitDepth,
+                                      std::unique_ptr<juce::AudioFormatWriter>& writer)
+    {
+        std::unique_ptr<juce::AudioFormat> format;
+
+        if (file.hasFileExtension ("flac"))
+            format = std::make_unique<juce::FlacAudioFormat>();
+        else
+            format = std::make_unique<juce::WavAudioFormat>();
+
+        if (! format->getPossibleBitDepths().contains (bitDepth))
+            return juce::Result::fail (format->getFormatName() + " can't write " + juce::String (bitDepth) + " bit");
+
+        auto folder = file.getParentDirectory();
+
+        if (! folder.createDirectory())
+            return juce::Result::fail ("couldn't create " + folder.getFullPathName());
+
+        file.deleteFile();
+        std::unique_ptr<juce::FileOutputStream> stream (file.createOutputStream());
+
+        if (stream == nullptr || stream->failedToOpen())
+            return juce::Result::fail ("couldn't open " + file.getFullPathName());
+
+        writer.reset (format->createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels, bitDepth, {}, 0));
+
+        if (writer == nullptr)
+            return juce::Result::fail (format->getFormatName() + " can't write this rate/channel count");
+
+        stream.release(); // the writer owns it now
+        return juce::Result::ok();
+    }
+
+    // the most samples of a job that fit in a worker's buffer, in whole chunks
+    static juce::int64 getPieceLength (const RenderJob& job) noexcept
+    {
+        return juce::jmax (1, bufferSize / job.numChannels / chunkSize) * (juce::int64) chunkSize;
+    }
+
+    // Renders a whole job, writing each chunk as it's done
+    static juce::Result renderJob (SIGAudioProcessor& processor, const RenderJob& job, juce::AudioBuffer<float>& chunk)
+    {
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        auto opened = createWriter (job.outputFile, job.sampleRate, job.numChannels, job.bitDepth, writer);
+
+        if (opened.failed())
+            return opened;
+
+        prepareProcessor (processor, job);
+        chunk.setSize (job.numChannels, chunkSize, false, false, true);
+
+        juce::MidiBuffer midi;
+        auto remaining = job.getLengthInSamples();
+
+        while (remaining > 0)
+        {
+            auto numSamples = (int) juce::jmin ((juce::int64) chunkSize, remaining);
+            juce::AudioBuffer<float> block (chunk.getArrayOfWritePointers(), job.numChannels, numSamples);
+
+            processor.processBlock (block, midi);
+
+            if (! writer->writeFromAudioSampleBuffer (block, 0, numSamples))
+            {
+                processor.releaseResources();
+                return juce::Result::fail ("write failed, disk full?");
+            }
+
+            remaining -= numSamples;
+        }
+
+        processor.releaseResources();
+
+        // the inverse filter is written as mono 32 bit float (24 bit for FLAC), it needs the headroom
+        if (job.inverseFile != juce::File())
+        {
+            auto inverse = processor.createSweepInverseFilter();
+            std::unique_ptr<juce::AudioFormatWriter> inverseWriter;
+            auto inverseOpened = createWriter (job.inverseFile, job.sampleRate, 1,
+                                               job.inverseFile.hasFileExtension ("flac") ? 24 : 32, inverseWriter);
+
+            if (inverseOpened.failed())
+                return inverseOpened;
+
+            if (! inverseWriter->writeFromAudioSampleBuffer (inverse, 0, inverse.getNumSamples()))
+                return juce::Result::fail ("write failed, disk full?");
+        }
+
+        return juce::Result::ok();
+    }
+
+    // Renders numSamples of a job from sample start into buffer, which is resized to fit without reallocating
+    static void renderPiece (SIGAudioProcessor& processor, const RenderJob& job, juce::int64 start, int numSamples,
+                             juce::AudioBuffer<float>& buffer)
+    {
+        prepareProcessor (processor, job);
+        processor.seekNoise (start);
+        buffer.setSize (job.numChannels, numSamples, false, false, true);
+
+        juce::MidiBuffer midi;
+
+        for (int offset = 0; offset < numSamples; offset += chunkSize)
+        {
+            juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), job.numChannels, offset,
+                                            juce::jmin (chunkSize, numSamples - offset));
+            processor.processBlock (block, midi);
+        }
+
+        processor.releaseResources();
+    }
+
+private:
+
+    struct Piece
+    {
+        int jobIndex;
+        int index;          // of the job's pieces, they're written in this order
+        juce::int64 start;
+        juce::int64 numSamples;
+    };
+
+    struct JobProgress
+    {
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        juce::Result result { juce::Result::ok() };
+        int numPieces { 0 };
+        int nextPieceToWrite { 0 };
+        double startTime { 0.0 };
+    };
+
+    // parameters go in before prepareToPlay so the gain starts at its target with no ramp
+    static void prepareProcessor (SIGAudioProcessor& processor, const RenderJob& job)
+    {
+        processor.setNonRealtime (true);
+        processor.setPlayConfigDetails (job.numChannels, job.numChannels, job.sampleRate, chunkSize);
+
+        setParameter (processor, "signal", (float) job.signalType);
+        setParameter (processor, "routing", (float) job.routing);
+        setParameter (processor, "freq", job.frequency);
+        setParameter (processor, "pulseWidth", job.pulseWidth);
+        setParameter (processor, "gain", job.gainDecibels);
+        setParameter (processor, "gaussian", job.gaussian ? 1.0f : 0.0f);
+        setParameter (processor, "bypass", 1.0f);
+        setParameter (processor, "walkTime", job.walkSeconds);
+
+        // the sine cache swaps to its loop whenever the background build finishes, so a render with it on
+        // would differ from run to run. The live oscillator is what's rendered
+        setParameter (processor, "sineCache", 0.0f);
+
+        for (int channel = 0; channel < SIGAudioProcessor::maxChannels; ++channel)
+            setParameter (processor, "ch" + juce::String (channel + 1), ((job.channelMask >> channel) & 1) != 0 ? 1.0f : 0.0f);
+
+        setParameter (processor, "sweepMode", job.sweep.mode == SineSweep::Mode::linear ? 1.0f : 0.0f);
+        setParameter (processor, "sweepStart", (float) job.sweep.startFrequency);
+        setParameter (processor, "sweepEnd", (float) job.sweep.endFrequency);
+        setParameter (processor, "sweepTime", (float) job.sweep.seconds);
+        setParameter (processor, "sweepFadeIn", (float) job.sweep.fadeInSeconds);
+        setParameter (processor, "sweepFadeOut", (float) job.sweep.fadeOutSeconds);
+        setParameter (processor, "sweepRepeat", job.sweep.repeat ? 1.0f : 0.0f);
+        setParameter (processor, "sweepGap", (float) job.sweep.gapSeconds);
+
+        auto tones = job.tones;
+
+        if (tones.isEmpty())
+        {
+            tones = Multisine::makeThirdOctaveTones();
+            Multisine::setSchroederPhases (tones);
+        }
+
+        processor.setMultisineTones (tones);
+        processor.setNoiseSeed (job.seed);
+
+        processor.prepareToPlay (job.sampleRate, chunkSize);
+    }
+
+    // A one piece job renders and writes in one go. Otherwise the piece is rendered, then waits until the
+    // piece before it has been written and writes itself
+    void process (SIGAudioProcessor& processor, const Piece& piece, juce::AudioBuffer<float>& buffer)
+    {
+        auto& job = jobs.getReference (piece.jobIndex);
+        auto& jobProgress = progress[(size_t) piece.jobIndex];
+
+        if (piece.index == 0)
+        {
+            const std::lock_guard<std::mutex> lock (writeMutex);
+            jobProgress.startTime = juce::Time::getMillisecondCounterHiRes();
+        }
+
+        if (jobProgress.numPieces == 1)
+        {
+            finish (piece.jobIndex, renderJob (processor, job, buffer));
+            return;
+        }
+
+        renderPiece (processor, job, piece.start, (int) piece.numSamples, buffer);
+
+        {
+            std::unique_lock<std::mutex> lock (writeMutex);
+            pieceWritten.wait (lock, [&] { return jobProgress.nextPieceToWrite == piece.index; });
+        }
+
+        // only the piece whose turn it is touches the writer, so the write itself happens outside the lock
+        if (jobProgress.result.wasOk() && piece.index == 0)
+            jobProgress.result = createWriter (job.outputFile, job.sampleRate, job.numChannels, job.bitDepth, jobProgress.writer);
+
+        if (jobProgress.result.wasOk() && ! jobProgress.writer->writeFromAudioSampleBuffer (buffer, 0, (int) piece.numSamples))
+            jobProgress.result = juce::Result::fail ("write failed, disk full?");
+
+        auto isLast = piece.index == jobProgress.numPieces - 1;
+
+        if (isLast)
+        {
+            jobProgress.writer.reset();
+            finish (piece.jobIndex, jobProgress.result);
+        }
+
+        {
+            const std::lock_guard<std::mutex> lock (writeMutex);
+            ++jobProgress.nextPieceToWrite;
+        }
+
+        pieceWritten.notify_all();
+    }
+
+    void finish (int jobIndex, const juce::Result& result)
+    {
+        auto seconds = (juce::Time::getMillisecondCounterHiRes() - progress[(size_t) jobIndex].startTime) * 0.001;
+
+        results.getReference (jobIndex) = result;
+        report (jobs.getReference (jobIndex), result, seconds);
+    }
+
+    static void setParameter (SIGAudioProcessor& processor, const juce::String& paramID, float value)
+    {
+        auto* param = processor.treeState.getParameter (paramID);
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    class Worker  : public juce::Thread
+    {
+    public:
+
+        Worker (OfflineRenderer& ownerToUse, int index)
+            : juce::Thread ("SIG render " + juce::String (index)), owner (ownerToUse)
+        {
+            chunk.setSize (SIGAudioProcessor::maxChannels, chunkSize);
+        }
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                auto pieceIndex = owner.nextPiece++;
+
+                if (pieceIndex >= (int) owner.pieces.size())
+                    break;
+
+                owner.process (processor, owner.pieces[(size_t) pieceIndex], chunk);
+            }
+        }
+
+    private:
+
+        OfflineRenderer& owner;
+        SIGAudioProcessor processor;
+        juce::AudioBuffer<float> chunk;
+    };
+
+    void report (const RenderJob& job, const juce::Result& result, double secondsTaken)
+    {
+        const juce::ScopedLock sl (consoleLock);
+        auto done = ++numReported;
+
+        std::cout << "[" << done << "/" << jobs.size() << "] " << job.outputFile.getFullPathName();
+
+        if (result.wasOk())
+            std::cout << "  " << juce::String (job.seconds / juce::jmax (secondsTaken, 1.0e-6), 0) << "x realtime" << std::endl;
+        else
+            std::cout << "  FAILED: " << result.getErrorMessage() << std::endl;
+    }
+
+    const juce::Array<RenderJob>& jobs;
+    juce::Array<juce::Result> results;
+    std::vector<Piece> pieces;
+    std::vector<JobProgress> progress;
+    std::mutex writeMutex;
+    std::condition_variable pieceWritten;
+    juce::OwnedArray<Worker> workers;
+    std::atomic<int> nextPiece { 0 };
+    juce::CriticalSection consoleLock;
+    int numReported { 0 };
+};
+
+} // namespace render
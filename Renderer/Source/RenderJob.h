@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    RenderJob.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../Source/SineSweep.h"
+#include "../../Source/Multisine.h"
+
+// One line of a job list, e.g.
+//     file=tones/sine_1k_-20.wav signal=sine freq=1000 gain=-20 rate=96000 bits=24 seconds=30
+//     file=arrays/pink_walk_16.wav signal=pink routing=walk channels=16 mask=1,3,5,7 walktime=0.5
+//     file=ir/ess_20_20k.wav signal=sweep sweep=log start=20 end=20000 sweeptime=10 seconds=12 inverse=ir/ess_20_20k_inv.wav
+//     file=multi/three.wav signal=multisine tones=100:1:0,1000:0.5:0.25,10000:0.25 seconds=10
+//     file=shapes/pulse_100_25.wav signal=square freq=100 width=0.25
+//     file=noise/pink_10h.flac signal=pink seconds=36000 seed=7
+// Anything left out keeps the default below. The file extension picks the format (.wav or .flac)
+// and relative paths are relative to the output folder
+
+namespace render
+{
+
+struct RenderJob
+{
+    juce::File outputFile;
+    int signalType { 0 };       // index into the plugin's Signal choice
+    int routing { 1 };          // index into the plugin's Routing choice
+    std::uint64_t channelMask { ~std::uint64_t (0) }; // channels on for custom and walk, bit n is channel n + 1
+    float walkSeconds { 1.0f };
+    SineSweep::Parameters sweep;
+    juce::File inverseFile;     // where the sweep's inverse filter goes, none if it's not set
+    juce::Array<Multisine::Tone> tones;     // the plugin's default third octave set if it's empty
+    float frequency { 1000.0f };
+    float pulseWidth { 0.5f };  // square only
+    float gainDecibels { -20.0f };
+    bool gaussian { false };
+    std::uint64_t seed { 1 };   // noise seed, the same seed renders the same noise
+    double sampleRate { 48000.0 };
+    int bitDepth { 24 };
+    int numChannels { 2 };
+    double seconds { 10.0 };
+
+    juce::int64 getLengthInSamples() const noexcept
+    {
+        return (juce::int64) std::llround (seconds * sampleRate);
+    }
+
+    // White and pink noise can start at any sample (SIGAudioProcessor::seekNoise) so those jobs can be split
+    // over threads. Walk routing isn't, where it has got to depends on every block before
+    bool canBeSplit() const noexcept
+    {
+        return (signalType == 1 || signalType == 2) && routing != 4;
+    }
+
+    static juce::Result parse (const juce::String& line, const juce::File& outputFolder, RenderJob& job)
+    {
+        static const juce::StringArray signalNames { "sine", "white", "pink", "sweep", "multisine", "saw", "square", "triangle" };
+        static const juce::StringArray routingNames { "l", "lr", "r", "custom", "walk" };
+
+        auto tokens = juce::StringArray::fromTokens (line, " \t", "\"");
+
+        for (auto token : tokens)
+        {
+            auto key = token.upToFirstOccurrenceOf ("=", false, false).trim().toLowerCase();
+            auto value = token.fromFirstOccurrenceOf ("=", false, false).trim().unquoted();
+
+            if (key.isEmpty() || value.isEmpty())
+                return juce::Result::fail ("expected key=value, got \"" + token + "\"");
+
+            if (key == "file")           job.outputFile = outputFolder.getChildFile (value);
+            else if (key == "signal")    job.signalType = signalNames.indexOf (value, true);
+            else if (key == "routing")   job.routing = routingNames.indexOf (value, true);
+            else if (key == "freq")      job.frequency = value.getFloatValue();
+            else if (key == "width")     job.pulseWidth = value.getFloatValue();
+            else if (key == "gain")      job.gainDecibels = value.getFloatValue();
+            else if (key == "gaussian")  job.gaussian = value.getIntValue() != 0 || value.equalsIgnoreCase ("true");
+            else if (key == "seed")      job.seed = (std::uint64_t) value.getLargeIntValue();
+            else if (key == "rate")      job.sampleRate = value.getDoubleValue();
+            else if (key == "bits")      job.bitDepth = value.getIntValue();
+            else if (key == "channels")  job.numChannels = value.getIntValue();
+            else if (key == "seconds")   job.seconds = value.getDoubleValue();
+            else if (key == "walktime")  job.walkSeconds = value.getFloatValue();
+            else if (key == "sweep")     job.sweep.mode = value.equalsIgnoreCase ("linear") ? SineSweep::Mode::linear : SineSweep::Mode::logarithmic;
+            else if (key == "start")     job.sweep.startFrequency = value.getDoubleValue();
+            else if (key == "end")       job.sweep.endFrequency = value.getDoubleValue();
+            else if (key == "sweeptime") job.sweep.seconds = value.getDoubleValue();
+            else if (key == "fadein")    job.sweep.fadeInSeconds = value.getDoubleValue();
+            else if (key == "fadeout")   job.sweep.fadeOutSeconds = value.getDoubleValue();
+            else if (key == "repeat")    job.sweep.repeat = value.getIntValue() != 0 || value.equalsIgnoreCase ("true");
+            else if (key == "gap")       job.sweep.gapSeconds = value.getDoubleValue();
+            else if (key == "inverse")   job.inverseFile = outputFolder.getChildFile (value);
+            else if (key == "tones")     job.tones = Multisine::parseTones (value);
+            else if (key == "mask")
+            {
+                job.channelMask = 0;
+
+                for (auto channel : juce::StringArray::fromTokens (value, ",", ""))
+                {
+                    auto number = channel.getIntValue();
+
+                    if (number < 1 || number > 64)
+                        return juce::Result::fail ("mask channels must be 1 to 64");
+
+                    job.channelMask |= std::uint64_t (1) << (number - 1);
+                }
+            }
+            else return juce::Result::fail ("unknown key \"" + key + "\"");
+        }
+
+        if (job.outputFile == juce::File())
+            return juce::Result::fail ("no file=");
+
+        if (! job.outputFile.hasFileExtension ("wav;flac"))
+            return juce::Result::fail ("file must end in .wav or .flac");
+
+        if (job.signalType < 0)
+            return juce::Result::fail ("signal must be one of " + signalNames.joinIntoString (", "));
+
+        if (job.routing < 0)
+            return juce::Result::fail ("routing must be one of " + routingNames.joinIntoString (", "));
+
+        if (job.frequency < 20.0f || job.frequency > 21000.0f)
+            return juce::Result::fail ("freq must be 20 to 21000");
+
+        if (job.pulseWidth < 0.01f || job.pulseWidth > 0.99f)
+            return juce::Result::fail ("width must be 0.01 to 0.99");
+
+        if (job.gainDecibels < -120.0f || job.gainDecibels > 0.0f)
+            return juce::Result::fail ("gain must be -120 to 0");
+
+        if (job.sampleRate < 8000.0 || job.sampleRate > 384000.0)
+            return juce::Result::fail ("rate must be 8000 to 384000");
+
+        if (job.numChannels < 1 || job.numChannels > 64)
+            return juce::Result::fail ("channels must be 1 to 64");
+
+        if (job.walkSeconds < 0.1f || job.walkSeconds > 10.0f)
+            return juce::Result::fail ("walktime must be 0.1 to 10");
+
+        if (job.sweep.startFrequency < 20.0 || job.sweep.startFrequency > 21000.0
+             || job.sweep.endFrequency < 20.0 || job.sweep.endFrequency > 21000.0)
+            return juce::Result::fail ("start and end must be 20 to 21000");
+
+        if (job.sweep.seconds < 0.1 || job.sweep.seconds > 600.0)
+            return juce::Result::fail ("sweeptime must be 0.1 to 600");
+
+        if (job.inverseFile != juce::File() && ! job.inverseFile.hasFileExtension ("wav;flac"))
+            return juce::Result::fail ("inverse must end in .wav or .flac");
+
+        if (job.seconds <= 0.0)
+            return juce::Result::fail ("seconds must be more than 0");
+
+        return juce::Result::ok();
+    }
+};
+
+} // namespace render
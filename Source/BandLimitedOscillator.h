@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    BandLimitedOscillator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <cmath>
+
+// Saw, square/pulse and triangle from one phase accumulator with PolyBLEP and PolyBLAMP corrections,
+// no oversampling. The naive waveform's steps (saw, square) and corners (triangle) are smoothed over
+// the sample either side with 2 point polynomial residuals for a few multiplies a sample. That takes
+// 15dB or so off the saw and square aliasing, less off the triangle which starts a lot lower.
+// The residuals are written with max instead of ifs so the loops vectorise like SineOscillator's.
+// Phase is a double in cycles, process works on float or double blocks
+
+class BandLimitedOscillator
+{
+public:
+
+    enum class Waveform
+    {
+        saw,
+        square,
+        triangle
+    };
+
+    void prepare (double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        setFrequency (frequency);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        phase = 0.0;
+    }
+
+    // the corrections need less than half a cycle per sample, so it stops just short of Nyquist
+    void setFrequency (double newFrequency) noexcept
+    {
+        frequency = newFrequency;
+        increment = juce::jlimit (1.0e-9, 0.49, frequency / sampleRate);
+    }
+
+    double getFrequency() const noexcept { return frequency; }
+
+    void setWaveform (Waveform newWaveform) noexcept { waveform = newWaveform; }
+    Waveform getWaveform() const noexcept { return waveform; }
+
+    // fraction of the cycle the square is high for, 0.5 is a square and anything else a pulse
+    void setPulseWidth (double newWidth) noexcept { pulseWidth = juce::jlimit (0.01, 0.99, newWidth); }
+    double getPulseWidth() const noexcept { return pulseWidth; }
+
+    template <typename SampleType>
+    void process (SampleType* dest, int numSamples) noexcept
+    {
+        switch (waveform)
+        {
+            case Waveform::saw:      render<Waveform::saw> (dest, numSamples); break;
+            case Waveform::square:   render<Waveform::square> (dest, numSamples); break;
+            case Waveform::triangle: render<Waveform::triangle> (dest, numSamples); break;
+        }
+    }
+
+private:
+
+    template <Waveform Shape, typename SampleType>
+    void render (SampleType* dest, int numSamples) noexcept
+    {
+        const auto startPhase = phase;
+        const auto inc = increment;
+        const auto dt = (SampleType) inc;
+        const auto invDt = (SampleType) (1.0 / inc);
+        const auto width = (SampleType) pulseWidth;
+        const auto dcOffset = (SampleType) (2.0 * pulseWidth - 1.0); // a pulse's mean, taken off so it's centred on 0
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // phase 0 to 1 in double, only the wrapped value is narrowed
+            auto p = startPhase + inc * (double) i;
+            p -= (double) (int) p;
+            auto t = (SampleType) p;
+
+            if constexpr (Shape == Waveform::saw)
+            {
+                dest[i] = (SampleType) 2 * t - (SampleType) 1 - blep (t, invDt);
+            }
+            else if constexpr (Shape == Waveform::square)
+            {
+                // steps up at 0 and down at the width
+                auto t2 = t - width;
+                t2 += t2 < (SampleType) 0 ? (SampleType) 1 : (SampleType) 0;
+
+                auto naive = t < width ? (SampleType) 1 : (SampleType) -1;
+                dest[i] = naive - dcOffset + blep (t, invDt) - blep (t2, invDt);
+            }
+            else
+            {
+                // -1 at 0 and 1 at half a cycle, the slope changes by 8 per cycle at both corners
+                auto t2 = t + (SampleType) 0.5;
+                t2 -= t2 >= (SampleType) 1 ? (SampleType) 1 : (SampleType) 0;
+
+                auto naive = (SampleType) 1 - (SampleType) 4 * std::abs (t - (SampleType) 0.5);
+                dest[i] = naive + (SampleType) 8 * dt * (blamp (t, invDt) - blamp (t2, invDt));
+            }
+        }
+
+        phase = startPhase + inc * (double) numSamples;
+        phase -= std::floor (phase);
+    }
+
+    // Residual of a band limited unit step at phase 0, for t in 0 to 1 and invDt samples a cycle.
+    // u is 1 at the step and falls to 0 one sample after it, v does the same for the sample before
+    template <typename SampleType>
+    static inline SampleType blep (SampleType t, SampleType invDt) noexcept
+    {
+        auto u = std::max ((SampleType) 0, (SampleType) 1 - t * invDt);
+        auto v = std::max ((SampleType) 0, (SampleType) 1 - ((SampleType) 1 - t) * invDt);
+
+        return v * v - u * u;
+    }
+
+    // the same for a unit change of slope (per sample), the integral of the blep residual
+    template <typename SampleType>
+    static inline SampleType blamp (SampleType t, SampleType invDt) noexcept
+    {
+        auto u = std::max ((SampleType) 0, (SampleType) 1 - t * invDt);
+        auto v = std::max ((SampleType) 0, (SampleType) 1 - ((SampleType) 1 - t) * invDt);
+
+        return (u * u * u + v * v * v) * (SampleType) (1.0 / 3.0);
+    }
+
+    double sampleRate { 44100.0 };
+    double frequency { 440.0 };
+    double increment { 440.0 / 44100.0 };
+    double phase { 0.0 };
+    double pulseWidth { 0.5 };
+    Waveform waveform { Waveform::saw };
+};
@@ -0,0 +1,256 @@
+/*
+  ==============================================================================
+
+    BlockTimer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// How long each processBlock takes against its real time deadline (the block's length at the sample rate),
+// to see whether SIG has a part in a rig's dropouts.
+// The time comes from the CPU's cycle counter (rdtsc on Intel, the virtual counter on 64 bit ARM, the high
+// resolution timer anywhere else), two reads a block. Each block adds one to a histogram bin of its share of the
+// deadline and to every threshold it went over. Only the audio thread writes, so the counters are atomics
+// written with a plain load and store, no locked instructions, and readers on any thread get a Snapshot.
+// Build with SIG_BLOCK_TIMING=0 to take all of it out
+
+#ifndef SIG_BLOCK_TIMING
+ #define SIG_BLOCK_TIMING 1
+#endif
+
+#if SIG_BLOCK_TIMING
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+class BlockTimer
+{
+public:
+
+    static constexpr int binsPerDeadline = 32;
+    static constexpr int numBins = binsPerDeadline * 2;   // 0 to 2x the deadline, the last bin takes everything over
+    static constexpr int maxThresholds = 8;
+
+    struct Snapshot
+    {
+        std::array<std::uint64_t, numBins> bins {};
+        std::array<float, maxThresholds> thresholds {};
+        std::array<std::uint64_t, maxThresholds> overThreshold {};
+        int numThresholds { 0 };
+        std::uint64_t numBlocks { 0 };
+        double meanFraction { 0.0 };
+        double worstFraction { 0.0 };
+        double sampleRate { 0.0 };
+        int blockSize { 0 };
+    };
+
+    BlockTimer()
+    {
+        setThresholds ({ 0.5f, 0.75f, 1.0f });
+    }
+
+    // message thread, before the audio thread starts. Starts the counts again
+    void prepare (double newSampleRate, int newBlockSize)
+    {
+        sampleRate = newSampleRate;
+        blockSize = newBlockSize;
+        cyclesPerSample = getCyclesPerSecond() / newSampleRate;
+        reset();
+    }
+
+    // fractions of the deadline to count blocks over, up to maxThresholds of them. Safe while playing
+    void setThresholds (const juce::Array<float>& fractions) noexcept
+    {
+        auto num = juce::jmin (fractions.size(), maxThresholds);
+
+        for (int i = 0; i < num; ++i)
+        {
+            thresholds[(size_t) i].store (fractions[i], std::memory_order_relaxed);
+            overThreshold[(size_t) i].store (0, std::memory_order_relaxed);
+        }
+
+        numThresholds.store (num, std::memory_order_release);
+    }
+
+    //==============================================================================
+    // audio thread
+
+    static inline std::uint64_t now() noexcept
+    {
+       #if JUCE_INTEL
+        return (std::uint64_t) __rdtsc();
+       #elif JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC
+        std::uint64_t ticks;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (ticks));
+        return ticks;
+       #else
+        return (std::uint64_t) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    void record (std::uint64_t startCycles, int numSamples) noexcept
+    {
+        if (numSamples <= 0 || cyclesPerSample <= 0.0)
+            return;
+
+        auto fraction = (double) (now() - startCycles) / (cyclesPerSample * numSamples);
+
+        increment (bins[(size_t) juce::jlimit (0, numBins - 1, (int) (fraction * binsPerDeadline))]);
+        increment (numBlocks);
+        totalFraction.store (totalFraction.load (std::memory_order_relaxed) + fraction, std::memory_order_relaxed);
+
+        if (fraction > worstFraction.load (std::memory_order_relaxed))
+            worstFraction.store (fraction, std::memory_order_relaxed);
+
+        auto num = numThresholds.load (std::memory_order_acquire);
+
+        for (int i = 0; i < num; ++i)
+            if (fraction > thresholds[(size_t) i].load (std::memory_order_relaxed))
+                increment (overThreshold[(size_t) i]);
+    }
+
+    // times the scope it's in, for the top of processBlock
+    struct ScopedBlock
+    {
+        ScopedBlock (BlockTimer& timerToUse, int numSamplesToTime) noexcept
+            : timer (timerToUse), numSamples (numSamplesToTime), start (now()) {}
+
+        ~ScopedBlock() { timer.record (start, numSamples); }
+
+        BlockTimer& timer;
+        const int numSamples;
+        const std::uint64_t start;
+    };
+
+    //==============================================================================
+    // any thread
+
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot snapshot;
+
+        for (int i = 0; i < numBins; ++i)
+            snapshot.bins[(size_t) i] = bins[(size_t) i].load (std::memory_order_relaxed);
+
+        snapshot.numThresholds = numThresholds.load (std::memory_order_acquire);
+
+        for (int i = 0; i < snapshot.numThresholds; ++i)
+        {
+            snapshot.thresholds[(size_t) i] = thresholds[(size_t) i].load (std::memory_order_relaxed);
+            snapshot.overThreshold[(size_t) i] = overThreshold[(size_t) i].load (std::memory_order_relaxed);
+        }
+
+        snapshot.numBlocks = numBlocks.load (std::memory_order_relaxed);
+        snapshot.meanFraction = snapshot.numBlocks > 0 ? totalFraction.load (std::memory_order_relaxed) / (double) snapshot.numBlocks : 0.0;
+        snapshot.worstFraction = worstFraction.load (std::memory_order_relaxed);
+        snapshot.sampleRate = sampleRate;
+        snapshot.blockSize = blockSize;
+
+        return snapshot;
+    }
+
+    // the counts as text, a summary and then one line per histogram bin. Allocates
+    static juce::String toText (const Snapshot& snapshot)
+    {
+        juce::String text;
+        auto deadlineMs = snapshot.sampleRate > 0.0 ? 1000.0 * snapshot.blockSize / snapshot.sampleRate : 0.0;
+
+        text << "SIG processBlock timing " << juce::Time::getCurrentTime().toISO8601 (true) << juce::newLine
+             << "sample rate " << snapshot.sampleRate << ", block size " << snapshot.blockSize
+             << ", deadline " << juce::String (deadlineMs, 3) << " ms" << juce::newLine
+             << "blocks " << (juce::int64) snapshot.numBlocks
+             << ", mean " << juce::String (snapshot.meanFraction * 100.0, 2) << "%"
+             << ", worst " << juce::String (snapshot.worstFraction * 100.0, 2) << "% of the deadline" << juce::newLine;
+
+        for (int i = 0; i < snapshot.numThresholds; ++i)
+            text << "over " << juce::String (snapshot.thresholds[(size_t) i] * 100.0f, 1) << "%: "
+                 << (juce::int64) snapshot.overThreshold[(size_t) i] << juce::newLine;
+
+        text << "bin_start_percent,bin_end_percent,blocks" << juce::newLine;
+
+        for (int i = 0; i < numBins; ++i)
+            text << juce::String (100.0 * i / binsPerDeadline, 3) << ","
+                 << (i == numBins - 1 ? juce::String ("inf") : juce::String (100.0 * (i + 1) / binsPerDeadline, 3)) << ","
+                 << (juce::int64) snapshot.bins[(size_t) i] << juce::newLine;
+
+        return text;
+    }
+
+    juce::Result appendToFile (const juce::File& file) const
+    {
+        return file.appendText (toText (getSnapshot()) + juce::newLine)
+                 ? juce::Result::ok()
+                 : juce::Result::fail ("couldn't write " + file.getFullPathName());
+    }
+
+private:
+
+    static void increment (std::atomic<std::uint64_t>& count) noexcept
+    {
+        count.store (count.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void reset() noexcept
+    {
+        for (auto& bin : bins)
+            bin.store (0, std::memory_order_relaxed);
+
+        for (auto& count : overThreshold)
+            count.store (0, std::memory_order_relaxed);
+
+        numBlocks.store (0, std::memory_order_relaxed);
+        totalFraction.store (0.0, std::memory_order_relaxed);
+        worstFraction.store (0.0, std::memory_order_relaxed);
+    }
+
+    // the counter's rate, worked out once per process. The ARM counter says what it is, rdtsc is timed
+    // against the high resolution clock for 20ms (invariant TSC, so it doesn't move with the CPU's clock)
+    static double getCyclesPerSecond()
+    {
+        static const double cyclesPerSecond = []
+        {
+           #if JUCE_INTEL
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            auto startCycles = now();
+            auto endTicks = startTicks + juce::Time::secondsToHighResolutionTicks (0.02);
+
+            while (juce::Time::getHighResolutionTicks() < endTicks) {}
+
+            auto cycles = (double) (now() - startCycles);
+            return cycles / juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+           #elif JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC
+            std::uint64_t frequency;
+            asm volatile ("mrs %0, cntfrq_el0" : "=r" (frequency));
+            return (double) frequency;
+           #else
+            return (double) juce::Time::getHighResolutionTicksPerSecond();
+           #endif
+        }();
+
+        return cyclesPerSecond;
+    }
+
+    double sampleRate { 0.0 };
+    int blockSize { 0 };
+    double cyclesPerSample { 0.0 };
+
+    std::array<std::atomic<std::uint64_t>, numBins> bins {};
+    std::array<std::atomic<float>, maxThresholds> thresholds {};
+    std::array<std::atomic<std::uint64_t>, maxThresholds> overThreshold {};
+    std::atomic<int> numThresholds { 0 };
+    std::atomic<std::uint64_t> numBlocks { 0 };
+    std::atomic<double> totalFraction { 0.0 };
+    std::atomic<double> worstFraction { 0.0 };
+
+    JUCE_DECLARE_NON_COPYABLE (BlockTimer)
+};
+
+#endif
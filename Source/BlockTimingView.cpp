@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    BlockTimingView.cpp
+
+  ==============================================================================
+*/
+
+#include "BlockTimingView.h"
+
+#if SIG_BLOCK_TIMING
+
+BlockTimingView::BlockTimingView (BlockTimer& timerToUse)
+    : blockTimer (timerToUse)
+{
+    setMouseCursor (juce::MouseCursor::PointingHandCursor);
+    startTimerHz (10);
+}
+
+void BlockTimingView::timerCallback()
+{
+    auto newSnapshot = blockTimer.getSnapshot();
+
+    if (newSnapshot.numBlocks != snapshot.numBlocks)
+    {
+        snapshot = newSnapshot;
+        repaint();
+    }
+}
+
+void BlockTimingView::mouseUp (const juce::MouseEvent&)
+{
+    chooser = std::make_unique<juce::FileChooser> ("Save processBlock timing",
+                                                   juce::File::getSpecialLocation (juce::File::userDocumentsDirectory).getChildFile ("SIG timing.txt"),
+                                                   "*.txt");
+
+    chooser->launchAsync (juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles,
+                          [this] (const juce::FileChooser& fc)
+    {
+        auto file = fc.getResult();
+
+        if (file != juce::File())
+            file.replaceWithText (BlockTimer::toText (blockTimer.getSnapshot()));
+    });
+}
+
+void BlockTimingView::paint (juce::Graphics& g)
+{
+    auto area = getLocalBounds().toFloat().reduced (2.0f);
+
+    g.setColour (juce::Colours::darkslategrey.withAlpha (0.85f));
+    g.fillRoundedRectangle (area, 4.0f);
+
+    area.reduce (6.0f, 4.0f);
+
+    // summary on the right, histogram on the left
+    auto text = area.removeFromRight (area.getWidth() * 0.42f);
+    area.removeFromRight (6.0f);
+
+    g.setColour (juce::Colours::black.withAlpha (0.4f));
+    g.fillRect (area);
+
+    // bar heights are log scaled so the odd slow block still shows next to thousands of quick ones
+    std::uint64_t mostBlocks = 1;
+
+    for (auto count : snapshot.bins)
+        mostBlocks = juce::jmax (mostBlocks, count);
+
+    const auto barWidth = area.getWidth() / (float) BlockTimer::numBins;
+    const auto logMost = std::log1p ((double) mostBlocks);
+
+    for (int i = 0; i < BlockTimer::numBins; ++i)
+    {
+        auto count = snapshot.bins[(size_t) i];
+
+        if (count == 0)
+            continue;
+
+        auto height = area.getHeight() * (float) (std::log1p ((double) count) / logMost);
+        auto overDeadline = i >= BlockTimer::binsPerDeadline;
+
+        g.setColour (overDeadline ? juce::Colours::orangered : juce::Colours::lightskyblue);
+        g.fillRect (area.getX() + barWidth * (float) i, area.getBottom() - height, juce::jmax (1.0f, barWidth - 1.0f), height);
+    }
+
+    g.setColour (juce::Colours::white.withAlpha (0.6f));
+    g.drawVerticalLine ((int) area.getCentreX(), area.getY(), area.getBottom());
+
+    g.setColour (juce::Colours::white);
+    g.setFont (11.0f);
+
+    juce::String summary;
+    summary << "blocks " << (juce::int64) snapshot.numBlocks
+            << "\nmean " << juce::String (snapshot.meanFraction * 100.0, 1) << "%  worst " << juce::String (snapshot.worstFraction * 100.0, 1) << "%";
+
+    for (int i = 0; i < snapshot.numThresholds; ++i)
+        summary << (i == 0 ? "\n" : "  ") << ">" << juce::String (snapshot.thresholds[(size_t) i] * 100.0f, 0) << "% "
+                << (juce::int64) snapshot.overThreshold[(size_t) i];
+
+    g.drawFittedText (summary, text.toNearestInt(), juce::Justification::centredLeft, 4);
+}
+
+#endif
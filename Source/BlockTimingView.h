@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    BlockTimingView.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BlockTimer.h"
+
+#if SIG_BLOCK_TIMING
+
+// The BlockTimer's histogram for the editor: blocks by how much of their deadline processBlock took, with a line
+// at the deadline, and the counts over each threshold. Takes a snapshot on a 10Hz timer.
+// Clicking it saves the counts to a text file
+
+class BlockTimingView  : public juce::Component,
+                         private juce::Timer
+{
+public:
+    BlockTimingView (BlockTimer& timerToUse);
+
+    void paint (juce::Graphics&) override;
+    void mouseUp (const juce::MouseEvent&) override;
+
+private:
+
+    void timerCallback() override;
+
+    BlockTimer& blockTimer;
+    BlockTimer::Snapshot snapshot;
+    std::unique_ptr<juce::FileChooser> chooser;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockTimingView)
+};
+
+#endif
@@ -0,0 +1,367 @@
+/*
+  ==============================================================================
+
+    CachedSineOscillator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SineOscillator.h"
+#include "LoopTable.h"
+
+// SineOscillator that plays a steady tone from a loop once the frequency has held still for a moment.
+// numCycles / cycleLength is the closest fraction to frequency / sampleRate (under 0.0001 Hz off), so that many
+// cycles fit the loop exactly and it repeats without a seam. CachedSineBuilder renders it on the table builder
+// thread, the oscillator crossfades from live synthesis to the loop in phase and back to live as soon as the
+// frequency moves. The live oscillator stands still while looping and takes the loop's phase when it fades back
+
+class CachedSineOscillator
+{
+public:
+
+    static constexpr int maxCycleLength = 1 << 19;  // longest loop before the repeats, 10 s at 48k
+    static constexpr int minLoopLength = 4096;      // short loops are repeated up to this so the copies stay long
+    static constexpr double maxFrequencyError = 1.0e-4;
+
+    void prepare (double newSampleRate, int maxBlockSize)
+    {
+        sampleRate = newSampleRate;
+        osc.prepare (sampleRate);
+        scratch.assign ((size_t) juce::jmax (maxBlockSize, 1), 0.0f);
+
+        fadeLength = juce::jmax (1, juce::roundToInt (0.005 * sampleRate));
+        steadyLength = juce::roundToInt (0.1 * sampleRate);
+
+        current.reset();
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        osc.reset();
+        mode = Mode::live;
+        steadySamples = 0;
+        hasRequested = false;
+    }
+
+    void setCacheEnabled (bool shouldBeEnabled) noexcept { cacheEnabled = shouldBeEnabled; }
+
+    void setFrequency (double newFrequency) noexcept
+    {
+        if (newFrequency == osc.getFrequency())
+            return;
+
+        osc.setFrequency (newFrequency);
+        steadySamples = 0;
+        hasRequested = false;
+
+        if (mode == Mode::looping || mode == Mode::fadingToLoop)
+            startFade (Mode::fadingToLive);
+    }
+
+    double getFrequency() const noexcept { return osc.getFrequency(); }
+
+    bool isPlayingLoop() const noexcept { return mode == Mode::looping; }
+
+    // float or double blocks, the loop table is float either way (24 bit samples) and is widened for double.
+    // Turn the cache off to get the double precision polynomial all the time
+    template <typename SampleType>
+    void process (SampleType* dest, int numSamples) noexcept
+    {
+        jassert (numSamples <= (int) scratch.size());
+        updateMode (numSamples);
+
+        switch (mode)
+        {
+            case Mode::live:
+                osc.process (dest, numSamples);
+                break;
+
+            case Mode::looping:
+                readLoop (dest, numSamples);
+                break;
+
+            case Mode::fadingToLoop:
+            case Mode::fadingToLive:
+            {
+                osc.process (dest, numSamples);
+                readLoop (scratch.data(), numSamples);
+
+                auto toLoop = mode == Mode::fadingToLoop;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    auto g = juce::jmin (1.0f, (float) (fadePosition + i) / (float) fadeLength);
+                    auto loopGain = toLoop ? g : 1.0f - g;
+                    dest[i] += (SampleType) loopGain * ((SampleType) scratch[(size_t) i] - dest[i]);
+                }
+
+                fadePosition += numSamples;
+
+                if (fadePosition >= fadeLength)
+                    mode = toLoop ? Mode::looping : Mode::live;
+
+                break;
+            }
+        }
+    }
+
+    //==============================================================================
+    // the builder's side
+
+    LoopTableExchange& getExchange() noexcept { return exchange; }
+
+    // The audio thread asks for a loop once per steady stretch by bumping the request number,
+    // read the number first then the frequency and rate that go with it
+    int getRequestNumber() const noexcept { return requestNumber.load (std::memory_order_acquire); }
+    double getRequestedFrequency() const noexcept { return requestedFrequency.load(); }
+    double getRequestedSampleRate() const noexcept { return requestedSampleRate.load(); }
+
+    // The loop for a frequency, or nullptr if no fraction with a short enough cycle gets close enough.
+    // Samples come from the same polynomial as the live oscillator so the crossfade is between equal signals
+    static std::unique_ptr<LoopTable> createTable (double frequency, double tableSampleRate)
+    {
+        auto numCycles = 0;
+        auto cycleLength = 0;
+
+        if (! findCycleFraction (frequency / tableSampleRate, numCycles, cycleLength))
+            return {};
+
+        if (std::abs (numCycles * tableSampleRate / cycleLength - frequency) > maxFrequencyError)
+            return {};
+
+        auto table = std::make_unique<LoopTable>();
+        table->sampleRate = tableSampleRate;
+        table->frequency = frequency;
+        table->cycleLength = cycleLength;
+        table->numCycles = numCycles;
+        table->inverseCycles = inverseModulo (numCycles, cycleLength);
+
+        auto numRepeats = (minLoopLength + cycleLength - 1) / cycleLength;
+        table->samples.resize ((size_t) (cycleLength * numRepeats));
+
+        for (size_t i = 0; i < table->samples.size(); ++i)
+        {
+            // the phase is worked out exactly in integers, i * numCycles / cycleLength cycles
+            auto p = (double) (((juce::int64) i * numCycles) % cycleLength) / (double) cycleLength;
+            p -= (double) (int) (p + 0.5);
+            table->samples[i] = FastMath::sinCycles ((float) p);
+        }
+
+        return table;
+    }
+
+private:
+
+    enum class Mode
+    {
+        live,
+        fadingToLoop,
+        looping,
+        fadingToLive
+    };
+
+    void updateMode (int numSamples) noexcept
+    {
+        if (! cacheEnabled)
+        {
+            if (mode == Mode::looping || mode == Mode::fadingToLoop)
+                startFade (Mode::fadingToLive);
+
+            return;
+        }
+
+        if (mode != Mode::live)
+            return;
+
+        const auto frequency = osc.getFrequency();
+
+        // a new loop for the current frequency, anything else is out of date
+        exchange.update (current, [this, frequency] (const LoopTable& table)
+        {
+            return table.sampleRate == sampleRate && table.frequency == frequency;
+        });
+
+        steadySamples += numSamples;
+
+        if (steadySamples < steadyLength)
+            return;
+
+        if (current != nullptr && current->frequency == frequency && current->sampleRate == sampleRate)
+        {
+            loopPosition = getIndexForPhase (osc.getPhase());
+            startFade (Mode::fadingToLoop);
+        }
+        else if (! hasRequested)
+        {
+            requestedSampleRate.store (sampleRate);
+            requestedFrequency.store (frequency);
+            requestNumber.fetch_add (1, std::memory_order_release);
+            hasRequested = true;
+        }
+    }
+
+    // Coming off the loop the live phase starts from the loop's, so the two are in phase however long it played.
+    // Turning round part way through a fade starts the new one from the mix the old one had got to
+    void startFade (Mode fadeMode) noexcept
+    {
+        if (mode == Mode::looping)
+            osc.setPhase (getPhaseForIndex (loopPosition));
+
+        const auto isFading = mode == Mode::fadingToLoop || mode == Mode::fadingToLive;
+        fadePosition = isFading ? fadeLength - fadePosition : 0;
+        mode = fadeMode;
+    }
+
+    template <typename SampleType>
+    void readLoop (SampleType* dest, int numSamples) noexcept
+    {
+        const auto* table = current->samples.data();
+        const auto tableSize = (int) current->samples.size();
+
+        while (numSamples > 0)
+        {
+            auto numToCopy = juce::jmin (numSamples, tableSize - loopPosition);
+
+            if constexpr (std::is_same<SampleType, float>::value)
+                juce::FloatVectorOperations::copy (dest, table + loopPosition, numToCopy);
+            else
+                for (int i = 0; i < numToCopy; ++i)
+                    dest[i] = (SampleType) table[loopPosition + i];
+
+            loopPosition = (loopPosition + numToCopy) % tableSize;
+            dest += numToCopy;
+            numSamples -= numToCopy;
+        }
+    }
+
+    // sample i of a cycle is at phase i * numCycles / cycleLength, so the sample for a phase is
+    // round (phase * cycleLength) * numCycles^-1, all mod cycleLength
+    int getIndexForPhase (double phase) const noexcept
+    {
+        const auto length = (juce::int64) current->cycleLength;
+        auto step = (juce::int64) std::llround (phase * (double) length) % length;
+
+        return (int) ((step * current->inverseCycles) % length);
+    }
+
+    // and the other way, the phase of sample index is index * numCycles / cycleLength mod 1
+    double getPhaseForIndex (int index) const noexcept
+    {
+        const auto length = (juce::int64) current->cycleLength;
+        return (double) (((juce::int64) index * current->numCycles) % length) / (double) length;
+    }
+
+    // closest fraction to x with a denominator up to maxCycleLength, from the continued fraction convergents
+    static bool findCycleFraction (double x, int& numerator, int& denominator)
+    {
+        if (! (x > 0.0 && x < 0.5))
+            return false;
+
+        juce::int64 h0 = 0, h1 = 1, k0 = 1, k1 = 0;
+        auto remainder = x;
+
+        for (int term = 0; term < 64; ++term)
+        {
+            auto a = (juce::int64) std::floor (remainder);
+            auto h = a * h1 + h0;
+            auto k = a * k1 + k0;
+
+            if (k > maxCycleLength)
+                break;
+
+            numerator = (int) h;
+            denominator = (int) k;
+
+            auto fraction = remainder - (double) a;
+
+            if (fraction < 1.0e-12 || std::abs (x - (double) h / (double) k) < 1.0e-15)
+                break;
+
+            h0 = h1; h1 = h;
+            k0 = k1; k1 = k;
+            remainder = 1.0 / fraction;
+        }
+
+        return denominator > 1 && numerator > 0;
+    }
+
+    // a^-1 mod m by the extended Euclidean algorithm, a and m coprime
+    static int inverseModulo (int a, int m)
+    {
+        juce::int64 t = 0, newT = 1, r = m, newR = a;
+
+        while (newR != 0)
+        {
+            auto q = r / newR;
+            std::tie (t, newT) = std::make_tuple (newT, t - q * newT);
+            std::tie (r, newR) = std::make_tuple (newR, r - q * newR);
+        }
+
+        return (int) (t < 0 ? t + m : t);
+    }
+
+    SineOscillator osc;
+    std::unique_ptr<LoopTable> current;
+    LoopTableExchange exchange;
+    std::vector<float> scratch;
+
+    std::atomic<double> requestedFrequency { 0.0 };
+    std::atomic<double> requestedSampleRate { 0.0 };
+    std::atomic<int> requestNumber { 0 };
+    bool hasRequested { false };
+
+    Mode mode { Mode::live };
+    bool cacheEnabled { true };
+    double sampleRate { 44100.0 };
+    int loopPosition { 0 };
+    int fadePosition { 0 };
+    int fadeLength { 1 };
+    int steadySamples { 0 };
+    int steadyLength { 4410 };
+};
+
+//==============================================================================
+// Renders CachedSineOscillator loops on the table builder thread when the audio thread asks for one
+class CachedSineBuilder  : private juce::TimeSliceClient
+{
+public:
+
+    CachedSineBuilder (CachedSineOscillator& oscillatorToFeed, juce::TimeSliceThread& threadToUse)
+        : oscillator (oscillatorToFeed), thread (threadToUse)
+    {
+        thread.addTimeSliceClient (this);
+    }
+
+    ~CachedSineBuilder() override
+    {
+        thread.removeTimeSliceClient (this);
+    }
+
+private:
+
+    int useTimeSlice() override
+    {
+        oscillator.getExchange().collectGarbage();
+
+        auto request = oscillator.getRequestNumber();
+
+        // frequencies with no short enough loop just stay live
+        if (request != lastRequest)
+        {
+            lastRequest = request;
+
+            if (auto table = CachedSineOscillator::createTable (oscillator.getRequestedFrequency(),
+                                                                oscillator.getRequestedSampleRate()))
+                oscillator.getExchange().publish (std::move (table));
+        }
+
+        return 20;
+    }
+
+    CachedSineOscillator& oscillator;
+    juce::TimeSliceThread& thread;
+    int lastRequest { 0 };
+};
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    LoopTable.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// A buffer of samples that loops without a seam, plus the lock-free handoff of new tables from the
+// builder thread to the audio thread. The audio thread takes a new table with an atomic exchange and
+// leaves the one it replaced in a retire slot. It only fills that slot when it's empty and only the
+// builder empties it, so the audio thread never allocates or frees
+
+struct LoopTable
+{
+    std::vector<float> samples;
+    double sampleRate { 0.0 };
+    double frequency { 0.0 };       // for single tones, 0 otherwise
+    int cycleLength { 0 };          // for single tones: numCycles cycles take exactly cycleLength samples,
+    int numCycles { 0 };            // the table is a whole number of those
+    int inverseCycles { 0 };        // numCycles^-1 mod cycleLength, finds the index for a phase
+    std::uint64_t contentId { 0 };  // what the table was built from, two tables with the same id hold the same samples
+};
+
+class LoopTableExchange
+{
+public:
+
+    ~LoopTableExchange()
+    {
+        delete pending.exchange (nullptr);
+        delete retired.exchange (nullptr);
+    }
+
+    // builder thread: hands a table to the audio thread, replacing one it hasn't picked up yet
+    void publish (std::unique_ptr<LoopTable> table)
+    {
+        delete pending.exchange (table.release(), std::memory_order_acq_rel);
+    }
+
+    // builder thread: frees the table the audio thread finished with
+    void collectGarbage()
+    {
+        delete retired.exchange (nullptr, std::memory_order_acq_rel);
+    }
+
+    // Audio thread: if a table is waiting and isWanted says yes it becomes current and this returns true.
+    // One that isn't wanted any more (built for an old sample rate or frequency) is retired unplayed
+    template <typename Predicate>
+    bool update (std::unique_ptr<LoopTable>& current, Predicate&& isWanted) noexcept
+    {
+        if (retired.load (std::memory_order_acquire) != nullptr)
+            return false;
+
+        auto* next = pending.exchange (nullptr, std::memory_order_acq_rel);
+
+        if (next == nullptr)
+            return false;
+
+        if (! isWanted (*next))
+        {
+            retired.store (next, std::memory_order_release);
+            return false;
+        }
+
+        retired.store (current.release(), std::memory_order_release);
+        current.reset (next);
+        return true;
+    }
+
+private:
+
+    std::atomic<LoopTable*> pending { nullptr };
+    std::atomic<LoopTable*> retired { nullptr };
+};
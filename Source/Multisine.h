@@ -0,0 +1,284 @@
+/*
+  ==============================================================================
+
+    Multisine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "LoopTable.h"
+
+// Multitone stimulus played from a loop table, so it costs a copy per sample however many tones there are.
+// The table is one period built with an inverse FFT: each tone is snapped to the nearest bin of an FFT at
+// least a second long (so under 1 Hz off) which makes the table loop without a seam, then it's normalised
+// to a peak of 1 and the plugin gain sets the level like it does for the sine.
+// Tables are built by MultisineBuilder on the plugin's table builder thread and handed over through a
+// LoopTableExchange, so the audio thread never allocates or frees
+
+class Multisine
+{
+public:
+
+    struct Tone
+    {
+        double frequency { 1000.0 };
+        float amplitude { 1.0f };
+        double phase { 0.0 };       // in cycles, 0 to 1, of a sine
+    };
+
+    using Table = LoopTable;
+
+    void prepare (double newSampleRate, std::unique_ptr<Table> firstTable)
+    {
+        sampleRate = newSampleRate;
+        current = std::move (firstTable);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        position = 0;
+    }
+
+    void process (float* dest, int numSamples) noexcept
+    {
+        // a table for an old sample rate is dropped, and so is one the same as the table playing (the background
+        // build for tones that prepare has already built). Swapping that in would restart it part way through
+        auto isWanted = [this] (const Table& table)
+        {
+            return table.sampleRate == sampleRate
+                && (current == nullptr || table.contentId != current->contentId);
+        };
+
+        if (exchange.update (current, isWanted))
+            position = 0;
+
+        if (current == nullptr || current->samples.empty())
+        {
+            juce::FloatVectorOperations::clear (dest, numSamples);
+            return;
+        }
+
+        const auto* table = current->samples.data();
+        const auto tableSize = (int) current->samples.size();
+
+        while (numSamples > 0)
+        {
+            auto numToCopy = juce::jmin (numSamples, tableSize - position);
+            juce::FloatVectorOperations::copy (dest, table + position, numToCopy);
+
+            position = (position + numToCopy) % tableSize;
+            dest += numToCopy;
+            numSamples -= numToCopy;
+        }
+    }
+
+    // the builder's side of the handoff
+    LoopTableExchange& getExchange() noexcept { return exchange; }
+
+    // One period of the tones at a sample rate. Allocates and runs a big FFT, keep it off the audio thread
+    static std::unique_ptr<Table> createTable (const juce::Array<Tone>& tones, double tableSampleRate)
+    {
+        auto table = std::make_unique<Table>();
+        table->sampleRate = tableSampleRate;
+        table->contentId = hashTones (tones);
+
+        if (tones.isEmpty() || tableSampleRate <= 0.0)
+            return table;
+
+        // at least a second long so every tone lands within 1 Hz of where it was asked for
+        auto order = juce::jlimit (10, 20, (int) std::ceil (std::log2 (tableSampleRate)));
+        juce::dsp::FFT fft (order);
+        const auto size = fft.getSize();
+
+        // only the positive bins are filled and the real part taken, the inverse FFT divides by size so
+        // a bin of amplitude * size gives amplitude * cos (phase), with a quarter cycle off that's a sine
+        std::vector<juce::dsp::Complex<float>> spectrum ((size_t) size);
+        std::vector<juce::dsp::Complex<float>> signal ((size_t) size);
+
+        for (auto& tone : tones)
+        {
+            auto bin = juce::roundToInt (tone.frequency * size / tableSampleRate);
+
+            if (bin < 1 || bin >= size / 2)
+                continue;
+
+            spectrum[(size_t) bin] += std::polar (tone.amplitude * (float) size,
+                                                  (float) ((tone.phase - 0.25) * juce::MathConstants<double>::twoPi));
+        }
+
+        fft.perform (spectrum.data(), signal.data(), true);
+
+        table->samples.resize ((size_t) size);
+        float peak = 0.0f;
+
+        for (int i = 0; i < size; ++i)
+        {
+            table->samples[(size_t) i] = signal[(size_t) i].real();
+            peak = juce::jmax (peak, std::abs (table->samples[(size_t) i]));
+        }
+
+        if (peak > 0.0f)
+            juce::FloatVectorOperations::multiply (table->samples.data(), 1.0f / peak, size);
+
+        return table;
+    }
+
+    //==============================================================================
+    // Tone lists
+
+    // third octave centres (base 10, 1kHz = band 30) from lowest to highest, all at the same level
+    static juce::Array<Tone> makeThirdOctaveTones (double lowest = 20.0, double highest = 20000.0)
+    {
+        juce::Array<Tone> tones;
+
+        for (int band = -30; band <= 14; ++band)
+        {
+            auto frequency = 1000.0 * std::pow (10.0, band / 10.0);
+
+            if (frequency >= lowest * 0.99 && frequency <= highest * 1.01)
+                tones.add ({ frequency, 1.0f, 0.0 });
+        }
+
+        return tones;
+    }
+
+    // Schroeder's low crest factor phases, phase k = -k (k - 1) / 2K cycles for K tones
+    static void setSchroederPhases (juce::Array<Tone>& tones)
+    {
+        const auto numTones = (double) tones.size();
+
+        for (int k = 1; k <= tones.size(); ++k)
+        {
+            auto phase = -(double) k * (double) (k - 1) / (2.0 * numTones);
+            tones.getReference (k - 1).phase = phase - std::floor (phase);
+        }
+    }
+
+    // "frequency:amplitude:phase" per tone separated by commas, amplitude and phase can be left off
+    static juce::String tonesToString (const juce::Array<Tone>& tones)
+    {
+        juce::StringArray items;
+
+        for (auto& tone : tones)
+            items.add (juce::String (tone.frequency, 3) + ":" + juce::String (tone.amplitude, 6) + ":" + juce::String (tone.phase, 6));
+
+        return items.joinIntoString (",");
+    }
+
+    static juce::Array<Tone> parseTones (const juce::String& text)
+    {
+        juce::Array<Tone> tones;
+
+        for (auto item : juce::StringArray::fromTokens (text, ",;", ""))
+        {
+            auto fields = juce::StringArray::fromTokens (item.trim(), ":", "");
+
+            if (fields.isEmpty() || fields[0].getDoubleValue() <= 0.0)
+                continue;
+
+            Tone tone;
+            tone.frequency = fields[0].getDoubleValue();
+            tone.amplitude = fields.size() > 1 ? fields[1].getFloatValue() : 1.0f;
+            tone.phase = fields.size() > 2 ? fields[2].getDoubleValue() : 0.0;
+            tones.add (tone);
+        }
+
+        return tones;
+    }
+
+private:
+
+    // FNV-1a over the tones' raw fields, tones that differ past the digits tonesToString prints still get their own id
+    static std::uint64_t hashTones (const juce::Array<Tone>& tones) noexcept
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+
+        auto add = [&hash] (const auto& field)
+        {
+            unsigned char bytes[sizeof (field)];
+            std::memcpy (bytes, &field, sizeof (field));
+
+            for (auto byte : bytes)
+                hash = (hash ^ byte) * 1099511628211ull;
+        };
+
+        for (auto& tone : tones)
+        {
+            add (tone.frequency);
+            add (tone.amplitude);
+            add (tone.phase);
+        }
+
+        return hash;
+    }
+
+    std::unique_ptr<Table> current;
+    LoopTableExchange exchange;
+    double sampleRate { 44100.0 };
+    int position { 0 };
+};
+
+//==============================================================================
+// Builds Multisine tables on the table builder thread when the tones or sample rate change and clears out
+// the retired ones. Requests are coalesced, only the latest one gets built
+class MultisineBuilder  : private juce::TimeSliceClient
+{
+public:
+
+    MultisineBuilder (Multisine& multisineToFeed, juce::TimeSliceThread& threadToUse)
+        : multisine (multisineToFeed), thread (threadToUse)
+    {
+        thread.addTimeSliceClient (this);
+    }
+
+    ~MultisineBuilder() override
+    {
+        thread.removeTimeSliceClient (this);
+    }
+
+    void requestTable (const juce::Array<Multisine::Tone>& tones, double sampleRate)
+    {
+        {
+            const juce::ScopedLock sl (requestLock);
+            requestedTones = tones;
+            requestedSampleRate = sampleRate;
+            hasRequest = true;
+        }
+
+        thread.moveToFrontOfQueue (this);
+    }
+
+private:
+
+    int useTimeSlice() override
+    {
+        multisine.getExchange().collectGarbage();
+
+        juce::Array<Multisine::Tone> tones;
+        double sampleRate = 0.0;
+        bool build = false;
+
+        {
+            const juce::ScopedLock sl (requestLock);
+            std::swap (build, hasRequest);
+            tones = requestedTones;
+            sampleRate = requestedSampleRate;
+        }
+
+        if (build)
+            multisine.getExchange().publish (Multisine::createTable (tones, sampleRate));
+
+        // back now and then anyway to empty the retire slot
+        return 50;
+    }
+
+    Multisine& multisine;
+    juce::TimeSliceThread& thread;
+    juce::CriticalSection requestLock;
+    juce::Array<Multisine::Tone> requestedTones;
+    double requestedSampleRate { 0.0 };
+    bool hasRequest { false };
+};
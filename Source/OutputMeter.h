@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    OutputMeter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Audio thread side of the editor's meters. processBlock pushes each block's output and this keeps
+// a peak/RMS summary of it plus the samples of the loudest channel, each in its own single producer
+// single consumer juce::AbstractFifo. Writing never waits and never allocates, anything that doesn't
+// fit because the editor has fallen behind is dropped.
+// Nothing is measured unless the editor has switched the meter on, so a closed editor costs one
+// relaxed atomic load a block
+
+class OutputMeter
+{
+public:
+
+    struct Summary
+    {
+        float peak { 0.0f };
+        float rms { 0.0f };
+        int numSamples { 0 };
+    };
+
+    static constexpr int summaryCapacity = 256;
+    static constexpr int sampleCapacity = 1 << 15; // about 0.7 s at 48k, plenty for a 30Hz display
+
+    OutputMeter()
+        : samples ((size_t) sampleCapacity)
+    {
+    }
+
+    // the editor turns the meter on when it opens and off when it closes
+    void setActive (bool shouldBeActive) noexcept { active.store (shouldBeActive); }
+    bool isActive() const noexcept { return active.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+    // audio thread
+
+    template <typename SampleType>
+    void push (const juce::AudioBuffer<SampleType>& buffer) noexcept
+    {
+        if (! isActive())
+            return;
+
+        const auto numSamples = buffer.getNumSamples();
+        const auto numChannels = buffer.getNumChannels();
+
+        if (numSamples == 0 || numChannels == 0)
+            return;
+
+        Summary summary;
+        summary.numSamples = numSamples;
+
+        auto loudestChannel = 0;
+        double sumOfSquares = 0.0;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* data = buffer.getReadPointer (channel);
+            auto range = juce::FloatVectorOperations::findMinAndMax (data, numSamples);
+            auto channelPeak = (float) juce::jmax (std::abs (range.getStart()), std::abs (range.getEnd()));
+
+            if (channelPeak > summary.peak)
+            {
+                summary.peak = channelPeak;
+                loudestChannel = channel;
+            }
+
+            SampleType channelSum = 0;
+
+            for (int i = 0; i < numSamples; ++i)
+                channelSum += data[i] * data[i];
+
+            sumOfSquares += (double) channelSum;
+        }
+
+        summary.rms = (float) std::sqrt (sumOfSquares / (double) (numSamples * numChannels));
+
+        writeSummary (summary);
+        writeSamples (buffer.getReadPointer (loudestChannel), numSamples);
+    }
+
+    //==============================================================================
+    // message thread
+
+    int readSummaries (Summary* dest, int maxSummaries) noexcept
+    {
+        int start1, size1, start2, size2;
+        summaryFifo.prepareToRead (maxSummaries, start1, size1, start2, size2);
+
+        std::copy (summaries.begin() + start1, summaries.begin() + start1 + size1, dest);
+        std::copy (summaries.begin() + start2, summaries.begin() + start2 + size2, dest + size1);
+
+        summaryFifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+    int readSamples (float* dest, int maxSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        sampleFifo.prepareToRead (maxSamples, start1, size1, start2, size2);
+
+        std::copy (samples.begin() + start1, samples.begin() + start1 + size1, dest);
+        std::copy (samples.begin() + start2, samples.begin() + start2 + size2, dest + size1);
+
+        sampleFifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+private:
+
+    void writeSummary (const Summary& summary) noexcept
+    {
+        int start1, size1, start2, size2;
+        summaryFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 > 0)
+            summaries[(size_t) start1] = summary;
+
+        summaryFifo.finishedWrite (size1);
+    }
+
+    template <typename SampleType>
+    void writeSamples (const SampleType* data, int numSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        sampleFifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+            samples[(size_t) (start1 + i)] = (float) data[i];
+
+        for (int i = 0; i < size2; ++i)
+            samples[(size_t) (start2 + i)] = (float) data[size1 + i];
+
+        sampleFifo.finishedWrite (size1 + size2);
+    }
+
+    std::atomic<bool> active { false };
+
+    juce::AbstractFifo summaryFifo { summaryCapacity };
+    std::array<Summary, summaryCapacity> summaries;
+
+    juce::AbstractFifo sampleFifo { sampleCapacity };
+    std::vector<float> samples;
+
+    JUCE_DECLARE_NON_COPYABLE (OutputMeter)
+};
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    OutputMeterView.cpp
+
+  ==============================================================================
+*/
+
+#include "OutputMeterView.h"
+
+OutputMeterView::OutputMeterView (OutputMeter& meterToUse, const juce::AudioProcessor& processorToUse)
+    : meter (meterToUse),
+      processor (processorToUse),
+      summaries ((size_t) OutputMeter::summaryCapacity),
+      incoming ((size_t) OutputMeter::sampleCapacity),
+      history ((size_t) fftSize, 0.0f),
+      fftData ((size_t) fftSize * 2, 0.0f),
+      spectrumDecibels ((size_t) fftSize / 2, minDecibels)
+{
+    // anything left in the fifos from the last time the editor was open is stale
+    meter.readSummaries (summaries.data(), (int) summaries.size());
+    meter.readSamples (incoming.data(), (int) incoming.size());
+
+    meter.setActive (true);
+    startTimerHz (30);
+}
+
+OutputMeterView::~OutputMeterView()
+{
+    meter.setActive (false);
+}
+
+void OutputMeterView::timerCallback()
+{
+    // peak holds and falls back at 20dB a second, rms is over everything since the last tick
+    auto numSummaries = meter.readSummaries (summaries.data(), (int) summaries.size());
+
+    auto peak = 0.0f;
+    double sumOfSquares = 0.0;
+    juce::int64 numSamples = 0;
+
+    for (int i = 0; i < numSummaries; ++i)
+    {
+        auto& summary = summaries[(size_t) i];
+        peak = juce::jmax (peak, summary.peak);
+        sumOfSquares += (double) summary.rms * (double) summary.rms * (double) summary.numSamples;
+        numSamples += summary.numSamples;
+    }
+
+    auto newPeak = juce::Decibels::gainToDecibels (peak, minDecibels);
+    peakDecibels = juce::jmax (newPeak, peakDecibels - 20.0f / 30.0f);
+
+    if (numSamples > 0)
+        rmsDecibels = juce::Decibels::gainToDecibels ((float) std::sqrt (sumOfSquares / (double) numSamples), minDecibels);
+    else
+        rmsDecibels = juce::jmax (minDecibels, rmsDecibels - 20.0f / 30.0f);
+
+    updateSpectrum();
+    repaint();
+}
+
+void OutputMeterView::updateSpectrum()
+{
+    auto numNew = meter.readSamples (incoming.data(), (int) incoming.size());
+
+    // keep the newest fftSize samples
+    if (numNew >= fftSize)
+    {
+        std::copy (incoming.begin() + (numNew - fftSize), incoming.begin() + numNew, history.begin());
+    }
+    else if (numNew > 0)
+    {
+        std::move (history.begin() + numNew, history.end(), history.begin());
+        std::copy (incoming.begin(), incoming.begin() + numNew, history.end() - numNew);
+    }
+
+    std::copy (history.begin(), history.end(), fftData.begin());
+    window.multiplyWithWindowingTable (fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform (fftData.data());
+
+    // a full scale sine on a bin comes out at fftSize / 4 through the hann window, that's 0dB.
+    // Bins rise straight away and fall at 40dB a second so the trace doesn't flicker
+    const auto scale = 4.0f / (float) fftSize;
+
+    for (size_t bin = 0; bin < spectrumDecibels.size(); ++bin)
+    {
+        auto level = juce::Decibels::gainToDecibels (fftData[bin] * scale, minDecibels);
+        spectrumDecibels[bin] = juce::jmax (level, spectrumDecibels[bin] - 40.0f / 30.0f);
+    }
+}
+
+void OutputMeterView::paint (juce::Graphics& g)
+{
+    auto area = getLocalBounds().toFloat().reduced (2.0f);
+
+    g.setColour (juce::Colours::darkslategrey.withAlpha (0.85f));
+    g.fillRoundedRectangle (area, 4.0f);
+
+    area.reduce (6.0f, 4.0f);
+
+    paintLevel (g, area.removeFromTop (16.0f));
+    area.removeFromTop (4.0f);
+    paintSpectrum (g, area);
+}
+
+void OutputMeterView::paintLevel (juce::Graphics& g, juce::Rectangle<float> area)
+{
+    auto text = area.removeFromRight (110.0f);
+    auto toWidth = [&] (float decibels) { return area.getWidth() * juce::jmap (decibels, minDecibels, 0.0f, 0.0f, 1.0f); };
+
+    g.setColour (juce::Colours::black.withAlpha (0.4f));
+    g.fillRect (area);
+
+    g.setColour (juce::Colours::lightskyblue);
+    g.fillRect (area.withWidth (toWidth (rmsDecibels)));
+
+    g.setColour (peakDecibels > -0.1f ? juce::Colours::orangered : juce::Colours::powderblue);
+    g.fillRect (area.getX() + toWidth (peakDecibels) - 1.0f, area.getY(), 2.0f, area.getHeight());
+
+    g.setColour (juce::Colours::white);
+    g.setFont (12.0f);
+    g.drawText ("pk " + juce::String (peakDecibels, 1) + "  rms " + juce::String (rmsDecibels, 1),
+                text, juce::Justification::centredRight);
+}
+
+void OutputMeterView::paintSpectrum (juce::Graphics& g, juce::Rectangle<float> area)
+{
+    g.setColour (juce::Colours::black.withAlpha (0.4f));
+    g.fillRect (area);
+
+    const auto sampleRate = processor.getSampleRate() > 0.0 ? processor.getSampleRate() : 44100.0;
+    const auto maxFrequency = juce::jmin (20000.0, sampleRate * 0.5);
+    const auto binWidth = sampleRate / (double) fftSize;
+    const auto numBins = (int) spectrumDecibels.size();
+
+    // log frequency, one point per pixel taking the loudest bin under it
+    auto frequencyAt = [&] (float x) { return 20.0 * std::pow (maxFrequency / 20.0, (double) (x / area.getWidth())); };
+    auto yFor = [&] (float decibels) { return area.getBottom() - area.getHeight() * juce::jmap (juce::jmax (decibels, minDecibels), minDecibels, 0.0f, 0.0f, 1.0f); };
+
+    juce::Path trace;
+
+    for (int x = 0; x < (int) area.getWidth(); ++x)
+    {
+        auto firstBin = juce::jlimit (1, numBins - 1, (int) (frequencyAt ((float) x) / binWidth));
+        auto lastBin = juce::jlimit (firstBin, numBins - 1, (int) (frequencyAt ((float) x + 1.0f) / binWidth));
+        auto level = minDecibels;
+
+        for (int bin = firstBin; bin <= lastBin; ++bin)
+            level = juce::jmax (level, spectrumDecibels[(size_t) bin]);
+
+        auto point = juce::Point<float> (area.getX() + (float) x, yFor (level));
+
+        if (x == 0)
+            trace.startNewSubPath (point);
+        else
+            trace.lineTo (point);
+    }
+
+    g.setColour (juce::Colours::lightgrey.withAlpha (0.25f));
+
+    for (auto decibels : { -20.0f, -40.0f, -60.0f, -80.0f, -100.0f })
+        g.drawHorizontalLine ((int) yFor (decibels), area.getX(), area.getRight());
+
+    g.setColour (juce::Colours::lightskyblue);
+    g.strokePath (trace, juce::PathStrokeType (1.2f));
+}
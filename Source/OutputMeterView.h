@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    OutputMeterView.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "OutputMeter.h"
+
+// Peak/RMS bar and spectrum of SIG's output for the editor. Reads the OutputMeter's fifos on a 30Hz
+// timer and does all of the work (the FFT included) on the message thread. It switches the meter on
+// while it exists so a closed editor leaves the audio thread alone
+
+class OutputMeterView  : public juce::Component,
+                         private juce::Timer
+{
+public:
+    OutputMeterView (OutputMeter& meterToUse, const juce::AudioProcessor& processorToUse);
+    ~OutputMeterView() override;
+
+    void paint (juce::Graphics&) override;
+
+private:
+
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr float minDecibels = -120.0f;
+
+    void timerCallback() override;
+    void updateSpectrum();
+    void paintLevel (juce::Graphics&, juce::Rectangle<float> area);
+    void paintSpectrum (juce::Graphics&, juce::Rectangle<float> area);
+
+    OutputMeter& meter;
+    const juce::AudioProcessor& processor;
+
+    // scratch for reading the fifos, sized once
+    std::vector<OutputMeter::Summary> summaries;
+    std::vector<float> incoming;
+
+    // the last fftSize samples, the spectrum is worked out from these every tick
+    std::vector<float> history;
+    std::vector<float> fftData;
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann };
+    std::vector<float> spectrumDecibels;
+
+    float peakDecibels { minDecibels };
+    float rmsDecibels { minDecibels };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OutputMeterView)
+};
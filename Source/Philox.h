@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    Philox.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//Philox4x32-10 from "Parallel Random Numbers: As Easy as 1, 2, 3" (Salmon et al, the Random123 library)
+//Counter based: each block of 4 random words is a pure function of a 128 bit counter and a 64 bit key,
+//so there's no state to step through and any point in a stream can be reached straight away. That's what
+//lets the noise seek and a long render be split over threads and still match a render done in one go.
+//It passes BigCrush, and the rounds are plain 32x32->64 multiplies and xors that vectorise across lanes
+
+struct Philox4x32
+{
+    static constexpr int numRounds = 10;
+
+    // numLanes blocks at once, counter[w][l] is word w of lane l's counter and becomes word w of its output
+    template <int NumLanes>
+    static inline void generate (std::uint32_t (&counter)[4][NumLanes], std::uint32_t key0, std::uint32_t key1) noexcept
+    {
+        // each lane goes through every round on its own, which is what lets the compiler put lanes side by side
+        for (int l = 0; l < NumLanes; ++l)
+        {
+            auto c0 = counter[0][l], c1 = counter[1][l], c2 = counter[2][l], c3 = counter[3][l];
+            auto k0 = key0, k1 = key1;
+
+            for (int round = 0; round < numRounds; ++round)
+            {
+                auto product0 = (std::uint64_t) multiplier0 * c0;
+                auto product1 = (std::uint64_t) multiplier1 * c2;
+
+                c0 = (std::uint32_t) (product1 >> 32) ^ c1 ^ k0;
+                c1 = (std::uint32_t) product1;
+                c2 = (std::uint32_t) (product0 >> 32) ^ c3 ^ k1;
+                c3 = (std::uint32_t) product0;
+
+                k0 += weyl0;
+                k1 += weyl1;
+            }
+
+            counter[0][l] = c0;
+            counter[1][l] = c1;
+            counter[2][l] = c2;
+            counter[3][l] = c3;
+        }
+    }
+
+    // one block, for seeking
+    static inline void generate (std::uint32_t (&words)[4], std::uint32_t key0, std::uint32_t key1) noexcept
+    {
+        std::uint32_t counter[4][1] = { { words[0] }, { words[1] }, { words[2] }, { words[3] } };
+        generate<1> (counter, key0, key1);
+
+        for (int w = 0; w < 4; ++w)
+            words[w] = counter[w][0];
+    }
+
+    // -1 to 1 from the top 24 bits, no DC offset
+    static inline float toBipolar (std::uint32_t word) noexcept
+    {
+        return (float) (word >> 8) * (2.0f / 16777216.0f) - 1.0f;
+    }
+
+    static constexpr std::uint32_t multiplier0 = 0xD2511F53;
+    static constexpr std::uint32_t multiplier1 = 0xCD9E8D57;
+    static constexpr std::uint32_t weyl0 = 0x9E3779B9;
+    static constexpr std::uint32_t weyl1 = 0xBB67AE85;
+};
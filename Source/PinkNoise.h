@@ -10,50 +10,203 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include "Philox.h"
 
-//found here https://www.firstpr.com.au/dsp/pink-noise/#Voss
+//Voss-McCartney pink noise, found here https://www.firstpr.com.au/dsp/pink-noise/#Voss
+//A counter picks which row to refresh each sample: row k is refreshed every 2^(k+1) samples, and the row
+//is the number of trailing zeros of the counter, so only one row is touched per sample instead of looping
+//over all of them. The sum of the rows plus one fresh white value per sample is -3dB/oct down to roughly
+//sampleRate / 2^numRows, so 16 rows is flat to below 20 Hz at 48k.
+//The white values come from Philox (see Philox.h) keyed on the sample number, so the value a row holds at
+//any sample can be worked out directly and seek is one Philox block per row. Noise is made in fixed chunks
+//of 32 samples so the output doesn't depend on the block sizes it's asked for.
+//Output is float -1 to 1, no scaling needed by the caller
 
-class PinkNumber
+class PinkNoise
 {
-private:
-    
-    int max_key;
-    int key;
-    unsigned int white_values[5];
-    unsigned int range;
-
 public:
-  
-    PinkNumber(unsigned int range = 128)
+    
+    static constexpr int maxRows = 32;
+    static constexpr int chunkSize = 32;
+    
+    PinkNoise(int numRows = 16, std::uint64_t seed = 0x5eed5eed5eed5eedull)
     {
-        max_key = 0x1f; // Five bits set
-        this->range = range;
-        key = 0;
-        for (int i = 0; i < 5; i++)
-        white_values[i] = rand() % (range/5);
+        setNumRows(numRows);
+        setSeed(seed);
     }
     
-    int GetNextValue()
+    void setNumRows(int newNumRows)
     {
-        int last_key = key;
-        unsigned int sum;
-
-        key++;
-        if (key > max_key)
-        key = 0;
-        // Exclusive-Or previous value with current value. This gives
-        // a list of bits that have changed.
-        int diff = last_key ^ key;
-        sum = 0;
-        for (int i = 0; i < 5; i++)
+        numRows = juce::jlimit(1, maxRows, newNumRows);
+        lastRowBit = std::uint32_t(1) << (numRows - 1); // stops the trailing zero count running past the last row
+        scale = 1.0f / (float) (numRows + 1);
+        reset();
+    }
+    
+    int getNumRows() const noexcept { return numRows; }
+    
+    // restarts the stream, same seed gives the same noise
+    void setSeed(std::uint64_t seed)
+    {
+        key0 = (std::uint32_t) seed;
+        key1 = (std::uint32_t) (seed >> 32);
+        reset();
+    }
+    
+    void reset()
+    {
+        seek(0);
+    }
+    
+    // carries on from sample position, the rows are rebuilt when the next chunk is made
+    void seek(std::int64_t newPosition) noexcept
+    {
+        position = newPosition;
+        currentChunk = -2;
+    }
+    
+    std::int64_t getPosition() const noexcept { return position; }
+    
+    void process(float* dest, int numSamples) noexcept
     {
+        for (int done = 0; done < numSamples;)
+        {
+            auto chunk = position / chunkSize;
+            auto offset = (int) (position - chunk * chunkSize);
+            auto num = juce::jmin(chunkSize - offset, numSamples - done);
+            
+            if (chunk != currentChunk)
+            {
+                // carrying straight on from the last chunk the rows are already right
+                if (chunk != currentChunk + 1)
+                    setRowsAt(chunk * chunkSize);
+                
+                renderChunk(chunk);
+                currentChunk = chunk;
+            }
+            
+            std::copy(output + offset, output + offset + num, dest + done);
+            position += num;
+            done += num;
+        }
+    }
+    
+private:
+    
+    // Sample n refreshes row countTrailingZeros((n + 1) | lastRowBit) with its first white value and adds its
+    // second fresh. Philox block n / 2 holds both for an even n in words 0 and 1 and for an odd n in 2 and 3
+    void renderChunk(std::int64_t chunk) noexcept
+    {
+        constexpr int numBlocks = chunkSize / 2;
+        alignas(32) std::uint32_t words[4][numBlocks];
+        alignas(32) float rowValues[chunkSize];
+        alignas(32) float freshValues[chunkSize];
+        
+        auto firstBlock = (std::uint64_t) chunk * numBlocks;
+        
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            words[0][b] = (std::uint32_t) (firstBlock + (std::uint64_t) b);
+            words[1][b] = (std::uint32_t) ((firstBlock + (std::uint64_t) b) >> 32);
+            words[2][b] = 0;
+            words[3][b] = rowDomain;
+        }
+        
+        Philox4x32::generate<numBlocks>(words, key0, key1);
+        
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            rowValues[b * 2] = Philox4x32::toBipolar(words[0][b]);
+            freshValues[b * 2] = Philox4x32::toBipolar(words[1][b]);
+            rowValues[b * 2 + 1] = Philox4x32::toBipolar(words[2][b]);
+            freshValues[b * 2 + 1] = Philox4x32::toBipolar(words[3][b]);
+        }
+        
+        // the running sum is rebuilt every chunk so float rounding can't build up over a long run
+        auto sum = 0.0f;
+        for (int i = 0; i < numRows; i++)
+            sum += rows[i];
         
-   // If bit changed get new random number for corresponding
-   // white_value
-    if (diff & (1 << i))
-    white_values[i] = rand() % (range/5);
-    sum += white_values[i];
+        auto counter = (std::uint32_t) (chunk * chunkSize);
+        
+        for (int sample = 0; sample < chunkSize; sample++)
+        {
+            auto row = countTrailingZeros(++counter | lastRowBit);
+            auto newValue = rowValues[sample];
+            
+            sum += newValue - rows[row];
+            rows[row] = newValue;
+            
+            output[sample] = (sum + freshValues[sample]) * scale;
+        }
     }
-      return sum;
+    
+    // The rows as they are just before sample start. Row k was last refreshed by the biggest counter up to
+    // start with exactly k trailing zeros (at least k for the last row), rows not refreshed yet hold a start value
+    void setRowsAt(std::int64_t start) noexcept
+    {
+        for (int k = 0; k < numRows; ++k)
+        {
+            auto period = std::int64_t (1) << k;
+            std::int64_t counter = 0;
+            
+            if (k == numRows - 1)
+                counter = (start / period) * period;
+            else if (start >= period)
+                counter = ((start - period) / (period * 2)) * (period * 2) + period;
+            
+            std::uint32_t words[4];
+            
+            if (counter > 0)
+            {
+                // sample counter - 1 did the refresh
+                auto block = (std::uint64_t) (counter - 1) / 2;
+                words[0] = (std::uint32_t) block;
+                words[1] = (std::uint32_t) (block >> 32);
+                words[2] = 0;
+                words[3] = rowDomain;
+                Philox4x32::generate(words, key0, key1);
+                
+                rows[k] = Philox4x32::toBipolar(((counter - 1) & 1) == 0 ? words[0] : words[2]);
+            }
+            else
+            {
+                words[0] = (std::uint32_t) k;
+                words[1] = 0;
+                words[2] = 0;
+                words[3] = startDomain;
+                Philox4x32::generate(words, key0, key1);
+                
+                rows[k] = Philox4x32::toBipolar(words[0]);
+            }
+        }
+        
+        for (int k = numRows; k < maxRows; ++k)
+            rows[k] = 0.0f;
     }
+    
+    static inline int countTrailingZeros(std::uint32_t x) noexcept
+    {
+       #if JUCE_MSVC
+        unsigned long index;
+        _BitScanForward(&index, x);
+        return (int) index;
+       #else
+        return __builtin_ctz(x);
+       #endif
+    }
+    
+    // counter word 3 keeps the per sample values and the start values apart
+    static constexpr std::uint32_t rowDomain = 0x70696e6b;   // 'pink'
+    static constexpr std::uint32_t startDomain = 0x726f7773; // 'rows'
+    
+    std::uint32_t key0 { 0 };
+    std::uint32_t key1 { 0 };
+    std::int64_t position { 0 };
+    std::int64_t currentChunk { -2 };
+    float rows[maxRows];
+    float output[chunkSize];
+    std::uint32_t lastRowBit { 0 };
+    float scale { 1.0f };
+    int numRows { 16 };
 };
@@ -16,38 +16,11 @@ SIGAudioProcessorEditor::SIGAudioProcessorEditor (SIGAudioProcessor& p)
     // SET DEFAULT FONT
     juce::LookAndFeel::getDefaultLookAndFeel().setDefaultSansSerifTypefaceName ("Avenir Next");
     
-    //SIGNAL TYPE BUTTONS AND ATTACHMENTS
-    sineButton.setClickingTogglesState(true);
-    sineButton.setRadioGroupId(1);
-    sineAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, "sine", sineButton);
-    addAndMakeVisible(sineButton);
+    //SIGNAL TYPE BUTTONS AND ATTACHMENT
+    signalAttachment = makeChoiceAttachment("signal", { &sineButton, &whiteButton, &pinkButton }, 1);
 
-    whiteButton.setClickingTogglesState(true);
-    whiteButton.setRadioGroupId(1);
-    whiteAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, "white", whiteButton);
-    addAndMakeVisible(whiteButton);
-    
-    pinkButton.setClickingTogglesState(true);
-    pinkButton.setRadioGroupId(1);
-    pinkAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, "pink", pinkButton);
-    addAndMakeVisible(pinkButton);
-
-    //ROUTING BUTTONS AND ATTACHMENTS
-    
-    lButton.setClickingTogglesState(true);
-    lButton.setRadioGroupId(2);
-    lAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, "l", lButton);
-    addAndMakeVisible(lButton);
-
-    lRButton.setClickingTogglesState(true);
-    lRButton.setRadioGroupId(2);
-    lrAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, "lr", lRButton);
-    addAndMakeVisible(lRButton);
-    
-    rButton.setClickingTogglesState(true);
-    rButton.setRadioGroupId(2);
-    rAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, "r", rButton);
-    addAndMakeVisible(rButton);
+    //ROUTING BUTTONS AND ATTACHMENT
+    routingAttachment = makeChoiceAttachment("routing", { &lButton, &lRButton, &rButton }, 2);
     
     //FREQ BUTTONS AND ATTACHMENTS
     freq.setDialStyle(bbg_gui::bbg_Dial::DialStyle::kDialModernStyle);
@@ -111,18 +84,43 @@ SIGAudioProcessorEditor::SIGAudioProcessorEditor (SIGAudioProcessor& p)
     onOffAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, "bypass", onOffSwitch);
     addAndMakeVisible(onOffSwitch);
     
-    // TITLE
-    sigTitle.setFont(juce::Font (30.0f, juce::Font::plain));
+    //SEQUENCER BUTTONS AND ATTACHMENT
+    sequencerSwitch.setClickingTogglesState(true);
+    sequencerAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, "sequencer", sequencerSwitch);
+    addAndMakeVisible(sequencerSwitch);
+    
+    loadSequenceButton.setClickingTogglesState(false);
+    loadSequenceButton.onClick = [this]()
+    {
+        sequenceChooser = std::make_unique<juce::FileChooser>("Load a test sequence",
+                                                              juce::File::getSpecialLocation(juce::File::userDocumentsDirectory),
+                                                              "*.txt");
+        
+        sequenceChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                     [this](const juce::FileChooser& chooser)
+        {
+            auto file = chooser.getResult();
+            
+            if(file == juce::File())
+                return;
+            
+            auto result = audioProcessor.loadTestSequence(file);
+            
+            if(result.failed())
+                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Test sequence", result.getErrorMessage());
+        });
+    };
+    addAndMakeVisible(loadSequenceButton);
+    
+    // TITLE (fonts are set in resized so they scale with the editor)
     sigTitle.setJustificationType(juce::Justification::centredLeft);
     sigTitle.setColour(juce::Label::textColourId, juce::Colours::darkslategrey);
     addAndMakeVisible(sigTitle);
     
-    sigVersion.setFont(juce::Font (16.0f, juce::Font::plain));
     sigVersion.setJustificationType(juce::Justification::centredLeft);
     sigVersion.setColour(juce::Label::textColourId, juce::Colours::dimgrey.brighter());
     addAndMakeVisible(sigVersion);
     
-    olumay.setFont(juce::Font (16.0f, juce::Font::plain));
     olumay.setJustificationType(juce::Justification::centredLeft);
     olumay.setColour(juce::Label::textColourId, juce::Colours::darkslategrey);
     addAndMakeVisible(olumay);
@@ -132,58 +130,152 @@ SIGAudioProcessorEditor::SIGAudioProcessorEditor (SIGAudioProcessor& p)
     signalGroup.setColour(juce::GroupComponent::ColourIds::textColourId, juce::Colours::grey);
     signalGroup.setTextLabelPosition(juce::Justification::centred);
     signalGroup.setText("SIGNAL TYPE");
-    addAndMakeVisible(signalGroup);
     
     routingGroup.setColour(juce::GroupComponent::ColourIds::outlineColourId, juce::Colours::lightgrey);
     routingGroup.setColour(juce::GroupComponent::ColourIds::textColourId, juce::Colours::grey);
     routingGroup.setTextLabelPosition(juce::Justification::centred);
     routingGroup.setText("ROUTING");
-    addAndMakeVisible(routingGroup);
     
     freqGroup.setColour(juce::GroupComponent::ColourIds::outlineColourId, juce::Colours::lightgrey);
     freqGroup.setColour(juce::GroupComponent::ColourIds::textColourId, juce::Colours::grey);
     freqGroup.setTextLabelPosition(juce::Justification::centred);
     freqGroup.setText("FREQUENCY");
-    addAndMakeVisible(freqGroup);
     
     gainGroup.setColour(juce::GroupComponent::ColourIds::outlineColourId, juce::Colours::lightgrey);
     gainGroup.setColour(juce::GroupComponent::ColourIds::textColourId, juce::Colours::grey);
     gainGroup.setTextLabelPosition(juce::Justification::centred);
     gainGroup.setText("GAIN");
-    addAndMakeVisible(gainGroup);
+    
+    // METERS
+    addAndMakeVisible(meterView);
+    
+   #if SIG_BLOCK_TIMING
+    addAndMakeVisible(timingView);
+   #endif
     
     // RESIZING
-    setResizable(false, false);
-//    setResizeLimits(350, 350, 500, 500);
-//    getConstrainer()->setFixedAspectRatio(1.0);
+    auto baseHeight = baseControlsHeight + baseMeterHeight + baseTimingHeight;
     
-    setSize (350, 350);
+    setOpaque(true);
+    setResizable(true, true);
+    setResizeLimits(baseWidth * 3 / 4, baseHeight * 3 / 4, baseWidth * 3, baseHeight * 3);
+    getConstrainer()->setFixedAspectRatio((double) baseWidth / (double) baseHeight);
+    
+    setSize (baseWidth, baseHeight);
 }
 
 SIGAudioProcessorEditor::~SIGAudioProcessorEditor()
 {
 }
 
+//Radio group of buttons driving a choice parameter, button n selects choice n
+std::unique_ptr<juce::ParameterAttachment> SIGAudioProcessorEditor::makeChoiceAttachment(const juce::String& paramID, juce::Array<juce::Button*> buttons, int radioGroup)
+{
+    auto attachment = std::make_unique<juce::ParameterAttachment>(*audioProcessor.treeState.getParameter(paramID), [buttons](float index)
+    {
+        for(int i = 0; i < buttons.size(); ++i)
+            buttons[i]->setToggleState(i == juce::roundToInt(index), juce::dontSendNotification);
+    });
+    
+    for(int i = 0; i < buttons.size(); ++i)
+    {
+        buttons[i]->setClickingTogglesState(true);
+        buttons[i]->setRadioGroupId(radioGroup);
+        buttons[i]->onClick = [attachment = attachment.get(), i]()
+        {
+            attachment->setValueAsCompleteGesture((float) i);
+        };
+        addAndMakeVisible(buttons[i]);
+    }
+    
+    attachment->sendInitialUpdate();
+    return attachment;
+}
+
 //==============================================================================
 void SIGAudioProcessorEditor::paint (juce::Graphics& g)
 {
-    juce::Rectangle<int> background = getLocalBounds();
-    g.setGradientFill(juce::ColourGradient::vertical(juce::Colours::powderblue, getHeight() * 0.78, juce::Colours::lightskyblue, getHeight()));
-    g.fillRect(background);
+    if(measureRepaints)
+        paintStartTicks = juce::Time::getHighResolutionTicks();
+    
+    //rebuilt after a resize or when the editor moves to a display with a different scale
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if(backgroundImage.isNull() || scale != backgroundScale)
+        renderBackground(scale);
+    
+    g.drawImage(backgroundImage, getLocalBounds().toFloat());
+}
+
+void SIGAudioProcessorEditor::paintOverChildren (juce::Graphics& g)
+{
+    if(!measureRepaints)
+        return;
+    
+    lastPaintMilliseconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - paintStartTicks) * 1000.0;
+    totalPaintMilliseconds += lastPaintMilliseconds;
+    ++numPaints;
+    
+    g.setColour(juce::Colours::black);
+    g.setFont(12.0f);
+    g.drawText("repaint " + juce::String(lastPaintMilliseconds, 3) + " ms, average " + juce::String(totalPaintMilliseconds / numPaints, 3)
+                 + " ms over " + juce::String(numPaints),
+               getLocalBounds().removeFromTop(16).reduced(4, 0), juce::Justification::centredRight);
+}
+
+//Background gradient and the four group borders, drawn at the display's pixel scale so they're sharp on HiDPI
+void SIGAudioProcessorEditor::renderBackground(float scale)
+{
+    backgroundScale = scale;
+    backgroundImage = juce::Image(juce::Image::RGB,
+                                  juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+                                  juce::jmax(1, juce::roundToInt(getHeight() * scale)),
+                                  false);
+    
+    juce::Graphics g(backgroundImage);
+    g.addTransform(juce::AffineTransform::scale(scale));
+    
+    auto controlsHeight = meterView.getY();
+    g.setGradientFill(juce::ColourGradient::vertical(juce::Colours::powderblue, controlsHeight * 0.78f, juce::Colours::lightskyblue, (float) controlsHeight));
+    g.fillRect(getLocalBounds());
+    
+    for(auto* group : { &signalGroup, &routingGroup, &freqGroup, &gainGroup })
+    {
+        juce::Graphics::ScopedSaveState saveState(g);
+        g.setOrigin(group->getPosition());
+        getLookAndFeel().drawGroupComponentOutline(g, group->getWidth(), group->getHeight(), group->getText(),
+                                                   group->getTextLabelPosition(), *group);
+    }
 }
 
 void SIGAudioProcessorEditor::resized()
 {
+    //the controls keep their square layout on top, the meters take the strip under them.
+    //Everything here scales with the width, the constrainer keeps the aspect ratio
+    auto scale = getWidth() / (float) baseWidth;
+    auto meterHeight = juce::roundToInt(baseMeterHeight * scale);
+    auto timingHeight = juce::roundToInt(baseTimingHeight * scale);
+    auto controlsHeight = getHeight() - meterHeight - timingHeight;
+    meterView.setBounds(0, controlsHeight, getWidth(), meterHeight);
+    
+   #if SIG_BLOCK_TIMING
+    timingView.setBounds(0, meterView.getBottom(), getWidth(), timingHeight);
+   #endif
+    
+    sigTitle.setFont(juce::Font (30.0f * scale, juce::Font::plain));
+    sigVersion.setFont(juce::Font (16.0f * scale, juce::Font::plain));
+    olumay.setFont(juce::Font (16.0f * scale, juce::Font::plain));
+    
     auto dialSize = getWidth() * 0.33;
     auto freqDialXPos = getWidth() * 0.087;
     auto gainDialXPos = getWidth() * 0.577;
-    auto dialY = getHeight() * 0.597;
-    auto leftMargin = getHeight() * 0.05;
+    auto dialY = controlsHeight * 0.597;
+    auto leftMargin = controlsHeight * 0.05;
     
     auto buttonWidth = getWidth() * 0.13;
-    auto buttonHeight = (getHeight()/7) * 0.5;
-    auto buttonTopMargin = getHeight() * 0.26;
-    auto buttonYPosSecondRow = getHeight() * 0.51;
+    auto buttonHeight = (controlsHeight/7) * 0.5;
+    auto buttonTopMargin = controlsHeight * 0.26;
+    auto buttonYPosSecondRow = controlsHeight * 0.51;
     auto buttonGap = getWidth() * 0.01428;
     auto buttonRightSideStartPos = getWidth() * 0.54;
     
@@ -220,20 +312,25 @@ void SIGAudioProcessorEditor::resized()
     gainGroup.setBounds(borderColTwoX, borderRowTwoY, borderWidth, largeBorderH);
     
     auto olumayX = getWidth() * 0.015;
-    auto olumayY = getHeight() * 0.938;
+    auto olumayY = controlsHeight * 0.938;
     auto olumayWidth = getWidth() * 0.3;
     auto sigTitleWidth = getWidth() * 0.17;
-    auto sigTitleHeight = getHeight() * 0.058;
+    auto sigTitleHeight = controlsHeight * 0.058;
     auto sigVersionX = getWidth() * 0.175;
-    auto sigVersionY = getHeight() * 0.05;
+    auto sigVersionY = controlsHeight * 0.05;
     auto sigVersionWidth = getWidth() * 0.233;
-    auto allTitlesHeight = getHeight() * 0.05;
-    auto titlesTopMargin = getHeight() * 0.05;
+    auto allTitlesHeight = controlsHeight * 0.05;
+    auto titlesTopMargin = controlsHeight * 0.05;
     
     olumay.setBounds(olumayX, olumayY, olumayWidth, allTitlesHeight);
     sigTitle.setBounds(olumayX, titlesTopMargin, sigTitleWidth, sigTitleHeight);
     sigVersion.setBounds(sigVersionX, sigVersionY, sigVersionWidth, allTitlesHeight);
     
     onOffSwitch.setBounds(buttonRightSideStartPos, titlesTopMargin, buttonWidth, buttonHeight);
+    sequencerSwitch.setBounds(onOffSwitch.getRight() + buttonGap, titlesTopMargin, buttonWidth, buttonHeight);
+    loadSequenceButton.setBounds(sequencerSwitch.getRight() + buttonGap, titlesTopMargin, buttonWidth, buttonHeight);
+    
+    //the group bounds have moved so the background gets redrawn on the next paint
+    backgroundImage = {};
     
 }
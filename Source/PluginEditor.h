@@ -10,6 +10,8 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "OutputMeterView.h"
+#include "BlockTimingView.h"
 #include "../Source/bbg_gui/Dial.h"
 #include "../Source/bbg_gui/Toggle.h"
 #include "../Source/bbg_gui/PushButton.h"
@@ -27,10 +29,21 @@ public:
 
     //==============================================================================
     void paint (juce::Graphics&) override;
+    void paintOverChildren (juce::Graphics&) override;
     void resized() override;
 
 private:
     
+    //the layout is designed at this size and scaled, the editor keeps its aspect ratio
+    static constexpr int baseWidth = 350;
+    static constexpr int baseControlsHeight = 350;
+    static constexpr int baseMeterHeight = 110;
+   #if SIG_BLOCK_TIMING
+    static constexpr int baseTimingHeight = 50;
+   #else
+    static constexpr int baseTimingHeight = 0;
+   #endif
+    
     //dials and buttons
     bbg_gui::bbg_PushButton sineButton { "Sine" };
     bbg_gui::bbg_PushButton whiteButton { "White" };
@@ -52,14 +65,14 @@ private:
     
     bbg_gui::bbg_PushButton onOffSwitch { "On" };
     
-    //Attachments    
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> sineAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> whiteAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> pinkAttachment;
+    //sequencer on/off and loading a step list
+    bbg_gui::bbg_PushButton sequencerSwitch { "Seq" };
+    bbg_gui::bbg_PushButton loadSequenceButton { "Load" };
+    std::unique_ptr<juce::FileChooser> sequenceChooser;
     
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> lAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> lrAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> rAttachment;
+    //Attachments    
+    std::unique_ptr<juce::ParameterAttachment> signalAttachment;
+    std::unique_ptr<juce::ParameterAttachment> routingAttachment;
     
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> freqAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> hundredAttachment;
@@ -71,6 +84,7 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> minusTwelveAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> minusSixAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> onOffAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> sequencerAttachment;
     
     
     //Labels
@@ -78,17 +92,40 @@ private:
     bbg_gui::bbg_dialLabel sigTitle { "S I G" };
     bbg_gui::bbg_dialLabel sigVersion { "version 1.1" };
     
-    //borders
-    
+    //borders, drawn into the background image rather than added as children
     juce::GroupComponent signalGroup;
     juce::GroupComponent freqGroup;
     juce::GroupComponent routingGroup;
     juce::GroupComponent gainGroup;
     
+    //the background gradient and group borders never change between resizes, so they're drawn once into
+    //an image at the display's pixel scale and paint just blits it
+    juce::Image backgroundImage;
+    float backgroundScale { 0.0f };
+    void renderBackground(float scale);
+    
+    //repaint cost mode, SIG_REPAINT_STATS=1 in the environment shows how long each repaint of the editor
+    //and its children takes, timed from paint to paintOverChildren
+    const bool measureRepaints { juce::SystemStats::getEnvironmentVariable("SIG_REPAINT_STATS", {}).getIntValue() != 0 };
+    juce::int64 paintStartTicks { 0 };
+    double lastPaintMilliseconds { 0.0 };
+    double totalPaintMilliseconds { 0.0 };
+    int numPaints { 0 };
+    
     
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     SIGAudioProcessor& audioProcessor;
+    
+    //output level and spectrum under the controls
+    OutputMeterView meterView { audioProcessor.getOutputMeter(), audioProcessor };
+    
+   #if SIG_BLOCK_TIMING
+    //processBlock timing histogram under the meters
+    BlockTimingView timingView { audioProcessor.getBlockTimer() };
+   #endif
+    
+    std::unique_ptr<juce::ParameterAttachment> makeChoiceAttachment(const juce::String& paramID, juce::Array<juce::Button*> buttons, int radioGroup);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SIGAudioProcessorEditor)
 };
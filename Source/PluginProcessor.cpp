@@ -22,42 +22,84 @@ SIGAudioProcessor::SIGAudioProcessor()
                        ), treeState(*this, nullptr, "PARAMETERS", createParameterLayout())
 #endif
 {
-    treeState.addParameterListener("gain", this);
-    treeState.addParameterListener("freq", this);
-    treeState.addParameterListener("bypass", this);
-    treeState.addParameterListener("routing", this);
-    treeState.addParameterListener("sine", this);
-    treeState.addParameterListener("white", this);
-    treeState.addParameterListener("pink", this);
-    treeState.addParameterListener("l", this);
-    treeState.addParameterListener("lr", this);
-    treeState.addParameterListener("r", this);
-    treeState.addParameterListener("hundred", this);
-    treeState.addParameterListener("thousand", this);
-    treeState.addParameterListener("tenThous", this);
-    treeState.addParameterListener("minus twenty", this);
-    treeState.addParameterListener("minus twelve", this);
-    treeState.addParameterListener("minus six", this);
+    //parameter atomics are looked up once here so processBlock never hashes a parameter ID
+    gainParam = treeState.getRawParameterValue("gain");
+    freqParam = treeState.getRawParameterValue("freq");
+    bypassParam = treeState.getRawParameterValue("bypass");
+    signalParam = treeState.getRawParameterValue("signal");
+    routingParam = treeState.getRawParameterValue("routing");
+    gaussianParam = treeState.getRawParameterValue("gaussian");
+    sineCacheParam = treeState.getRawParameterValue("sineCache");
+    walkTimeParam = treeState.getRawParameterValue("walkTime");
+    midiParam = treeState.getRawParameterValue("midi");
+    pulseWidthParam = treeState.getRawParameterValue("pulseWidth");
+    sharedParam = treeState.getRawParameterValue("shared");
+    sequencerParam = treeState.getRawParameterValue("sequencer");
+    sweepModeParam = treeState.getRawParameterValue("sweepMode");
+    sweepStartParam = treeState.getRawParameterValue("sweepStart");
+    sweepEndParam = treeState.getRawParameterValue("sweepEnd");
+    sweepTimeParam = treeState.getRawParameterValue("sweepTime");
+    sweepFadeInParam = treeState.getRawParameterValue("sweepFadeIn");
+    sweepFadeOutParam = treeState.getRawParameterValue("sweepFadeOut");
+    sweepRepeatParam = treeState.getRawParameterValue("sweepRepeat");
+    sweepGapParam = treeState.getRawParameterValue("sweepGap");
+    
+    for(int channel = 0; channel < maxChannels; ++channel)
+        channelParams[(size_t) channel] = treeState.getRawParameterValue("ch" + juce::String(channel + 1));
+    
+    //third octave multisine with low crest factor phases until the tones are set
+    multisineTones = Multisine::makeThirdOctaveTones();
+    Multisine::setSchroederPhases(multisineTones);
+    
+    events.reserve(maxEventsPerBlock);
+    
+    tableBuilderThread.startThread();
+    
+    //every instance gets its own noise streams
+    noiseSeed = (std::uint64_t) juce::Random::getSystemRandom().nextInt64();
+    pink.setSeed(noiseSeed);
+    
+    //presets and the saved state hold every parameter except the momentary shortcut buttons
+    const juce::StringArray momentaryIDs { "hundred", "thousand", "tenThous", "minus twenty", "minus twelve", "minus six" };
+    
+    for(auto* param : getParameters())
+    {
+        if(auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+        {
+            if(momentaryIDs.contains(ranged->paramID))
+                continue;
+            
+            presetParameters.add(ranged);
+            presetParameterValues.add(treeState.getRawParameterValue(ranged->paramID));
+        }
+    }
+    
+    setPresetBank(createFactoryBank());
+    startTimerHz(10);
+    
+    //the sequencer starts out with third octave tones at -20 and -40dB, a second each with a quarter second gap
+    testSequence = TestSequence::makeSteppedTones({ -20.0f, -40.0f }, 1.0, 0.25);
+    
+   #if SIG_BLOCK_TIMING
+    //SIG_BLOCK_TIMING_THRESHOLDS=0.25,0.5,1 in the environment changes the deadline fractions blocks are counted over
+    auto thresholds = juce::StringArray::fromTokens(juce::SystemStats::getEnvironmentVariable("SIG_BLOCK_TIMING_THRESHOLDS", {}), ",", {});
+    thresholds.removeEmptyStrings();
+    
+    if(! thresholds.isEmpty())
+    {
+        juce::Array<float> fractions;
+        
+        for(auto& threshold : thresholds)
+            fractions.add(threshold.getFloatValue());
+        
+        blockTimer.setThresholds(fractions);
+    }
+   #endif
 }
 
 SIGAudioProcessor::~SIGAudioProcessor()
 {
-    treeState.removeParameterListener("gain", this);
-    treeState.removeParameterListener("freq", this);
-    treeState.removeParameterListener("bypass", this);
-    treeState.removeParameterListener("routing", this);
-    treeState.removeParameterListener("sine", this);
-    treeState.removeParameterListener("white", this);
-    treeState.removeParameterListener("pink", this);
-    treeState.removeParameterListener("l", this);
-    treeState.removeParameterListener("lr", this);
-    treeState.removeParameterListener("r", this);
-    treeState.removeParameterListener("hundred", this);
-    treeState.removeParameterListener("thousand", this);
-    treeState.removeParameterListener("tenThous", this);
-    treeState.removeParameterListener("minus twenty", this);
-    treeState.removeParameterListener("minus twelve", this);
-    treeState.removeParameterListener("minus six", this);
+    stopTimer();
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout SIGAudioProcessor::createParameterLayout()
@@ -81,90 +123,112 @@ juce::AudioProcessorValueTreeState::ParameterLayout SIGAudioProcessor::createPar
                                                              [](float value, int) {return (value < 1000.0) ? juce::String (value, 1) + " Hz" : juce::String (value / 1000.0f, 2) + " kHz";});
     
     auto pBypass = std::make_unique<juce::AudioParameterBool>("bypass", "Bypass", 1);
-    auto pSineChoice = std::make_unique<juce::AudioParameterBool>("sine", "Sine", 1);
-    auto pWhiteChoice = std::make_unique<juce::AudioParameterBool>("white", "White", 0);
-    auto pPinkChoice = std::make_unique<juce::AudioParameterBool>("pink", "Pink", 0);
-    auto pLChoice = std::make_unique<juce::AudioParameterBool>("l", "L", 0);
-    auto pLRChoice = std::make_unique<juce::AudioParameterBool>("lr", "LR", 1);
-    auto pRChoice = std::make_unique<juce::AudioParameterBool>("r", "R", 0);
+    auto pSignal = std::make_unique<juce::AudioParameterChoice>("signal", "Signal", juce::StringArray { "Sine", "White", "Pink", "Sweep", "Multisine", "Saw", "Square", "Triangle" }, 0);
+    auto pRouting = std::make_unique<juce::AudioParameterChoice>("routing", "Routing", juce::StringArray { "L", "L+R", "R", "Custom", "Walk" }, 1);
     auto pHundred = std::make_unique<juce::AudioParameterBool>("hundred", "Hundred", 0);
     auto pThousand = std::make_unique<juce::AudioParameterBool>("thousand", "Thousand", 0);
     auto pTenThousand = std::make_unique<juce::AudioParameterBool>("tenThous", "tenThous", 0);
     auto pMinusTwenty = std::make_unique<juce::AudioParameterBool>("minus twenty", "Minus Twenty", 0);
     auto pMinusTwelve = std::make_unique<juce::AudioParameterBool>("minus twelve", "Minus Twelve", 0);
     auto pMinusSix = std::make_unique<juce::AudioParameterBool>("minus six", "Minus Six", 0);
+    auto pGaussian = std::make_unique<juce::AudioParameterBool>("gaussian", "Gaussian", 0);
+    auto pWalkTime = std::make_unique<juce::AudioParameterFloat>("walkTime",
+                                                                 "Walk Time",
+                                                                 juce::NormalisableRange<float>(0.1f, 10.0f, 0.01f, 0.5f),
+                                                                 1.0f,
+                                                                 juce::String(),
+                                                                 juce::AudioProcessorParameter::genericParameter,
+                                                                 [](float value, int) {return juce::String (value, 2) + " s";});
     
     params.push_back(std::move(pGain));
     params.push_back(std::move(pFreq));
     params.push_back(std::move(pBypass));
-    params.push_back(std::move(pSineChoice));
-    params.push_back(std::move(pWhiteChoice));
-    params.push_back(std::move(pPinkChoice));
-    params.push_back(std::move(pLChoice));
-    params.push_back(std::move(pLRChoice));
-    params.push_back(std::move(pRChoice));
+    params.push_back(std::move(pSignal));
+    params.push_back(std::move(pRouting));
     params.push_back(std::move(pHundred));
     params.push_back(std::move(pThousand));
     params.push_back(std::move(pTenThousand));
     params.push_back(std::move(pMinusTwenty));
     params.push_back(std::move(pMinusTwelve));
     params.push_back(std::move(pMinusSix));
+    params.push_back(std::move(pGaussian));
+    params.push_back(std::move(pWalkTime));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("sineCache", "Sine Cache", 1));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("midi", "MIDI Control", 0));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("pulseWidth", "Pulse Width", juce::NormalisableRange<float>(0.01f, 0.99f, 0.001f), 0.5f,
+                                                                 juce::String(), juce::AudioProcessorParameter::genericParameter,
+                                                                 [](float value, int) {return juce::String (value * 100.0f, 1) + " %";}));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("shared", "Shared Engine", 0));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("sequencer", "Sequencer", 0));
+    
+    //sweep
+    auto frequencyText = [](float value, int) {return (value < 1000.0) ? juce::String (value, 1) + " Hz" : juce::String (value / 1000.0f, 2) + " kHz";};
+    auto secondsText = [](float value, int) {return juce::String (value, 2) + " s";};
+    
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("sweepMode", "Sweep Mode", juce::StringArray { "Log", "Linear" }, 0));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("sweepStart", "Sweep Start", juce::NormalisableRange<float>(20.0f, 21000.0, 0.1, 0.3f), 20.0f,
+                                                                 juce::String(), juce::AudioProcessorParameter::genericParameter, frequencyText));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("sweepEnd", "Sweep End", juce::NormalisableRange<float>(20.0f, 21000.0, 0.1, 0.3f), 20000.0f,
+                                                                 juce::String(), juce::AudioProcessorParameter::genericParameter, frequencyText));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("sweepTime", "Sweep Time", juce::NormalisableRange<float>(0.1f, 600.0f, 0.01f, 0.3f), 10.0f,
+                                                                 juce::String(), juce::AudioProcessorParameter::genericParameter, secondsText));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("sweepFadeIn", "Sweep Fade In", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f, 0.5f), 0.05f,
+                                                                 juce::String(), juce::AudioProcessorParameter::genericParameter, secondsText));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("sweepFadeOut", "Sweep Fade Out", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f, 0.5f), 0.01f,
+                                                                 juce::String(), juce::AudioProcessorParameter::genericParameter, secondsText));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("sweepRepeat", "Sweep Repeat", 0));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("sweepGap", "Sweep Gap", juce::NormalisableRange<float>(0.0f, 10.0f, 0.01f, 0.5f), 1.0f,
+                                                                 juce::String(), juce::AudioProcessorParameter::genericParameter, secondsText));
+    
+    //channel enables for the Custom and Walk routings
+    for(int channel = 1; channel <= maxChannels; ++channel)
+        params.push_back(std::make_unique<juce::AudioParameterBool>("ch" + juce::String(channel), "Channel " + juce::String(channel), 1));
     
     return { params.begin(), params.end() };
 }
 
-void SIGAudioProcessor::parameterChanged(const juce::String &parameterID, float newValue)
+//Reads every parameter the dsp uses into one Settings snapshot. Only atomics are touched so it's safe on the
+//audio thread while the message thread or host changes parameters
+SIGAudioProcessor::Settings SIGAudioProcessor::readSettings() const
 {
-    gain.setTargetValue(juce::Decibels::decibelsToGain(treeState.getRawParameterValue("gain")->load()));
-    treeState.getRawParameterValue("freq")->load();
+    return makeSettings([](std::atomic<float>* param) { return param->load(); });
+}
 
-    if(parameterID == "bypass")
-    {
-        bypass = newValue;
-    }
-    treeState.getRawParameterValue("bypass")->load();
+//Builds Settings from plain parameter values, valueOf gets the value for a parameter's atomic. readSettings reads
+//the atomics themselves and compilePrograms reads a preset's values
+template <typename ValueSource>
+SIGAudioProcessor::Settings SIGAudioProcessor::makeSettings(ValueSource&& valueOf) const
+{
+    Settings newSettings;
     
-    auto sineChoice = treeState.getRawParameterValue("sine")->load();
-    auto whiteChoice = treeState.getRawParameterValue("white")->load();
-    auto pinkChoice = treeState.getRawParameterValue("pink")->load();
+    newSettings.gainDecibels = valueOf(gainParam);
+    newSettings.frequency = valueOf(freqParam);
+    newSettings.bypass = valueOf(bypassParam) >= 0.5f;
+    newSettings.gaussian = valueOf(gaussianParam) >= 0.5f;
+    newSettings.sineCache = valueOf(sineCacheParam) >= 0.5f;
+    newSettings.signalType = juce::jlimit(0, numSignalTypes - 1, juce::roundToInt(valueOf(signalParam)));
+    newSettings.routingChoice = juce::jlimit(0, numRoutings - 1, juce::roundToInt(valueOf(routingParam)));
+    newSettings.walkSeconds = valueOf(walkTimeParam);
+    newSettings.midiControl = valueOf(midiParam) >= 0.5f;
+    newSettings.pulseWidth = valueOf(pulseWidthParam);
+    newSettings.shared = valueOf(sharedParam) >= 0.5f;
+    newSettings.sequencer = valueOf(sequencerParam) >= 0.5f;
     
-    if(sineChoice == 1 && whiteChoice == 0 && pinkChoice == 0)
-    {
-        signalType = 0;
-    }
-    if(sineChoice == 0 && whiteChoice == 1 && pinkChoice == 0)
-    {
-        signalType = 1;
-    }
-    if(sineChoice == 0 && whiteChoice == 0 && pinkChoice == 1)
-    {
-        signalType = 2;
-    }
+    newSettings.sweep.mode = valueOf(sweepModeParam) >= 0.5f ? SineSweep::Mode::linear : SineSweep::Mode::logarithmic;
+    newSettings.sweep.startFrequency = valueOf(sweepStartParam);
+    newSettings.sweep.endFrequency = valueOf(sweepEndParam);
+    newSettings.sweep.seconds = valueOf(sweepTimeParam);
+    newSettings.sweep.fadeInSeconds = valueOf(sweepFadeInParam);
+    newSettings.sweep.fadeOutSeconds = valueOf(sweepFadeOutParam);
+    newSettings.sweep.repeat = valueOf(sweepRepeatParam) >= 0.5f;
+    newSettings.sweep.gapSeconds = valueOf(sweepGapParam);
+    newSettings.channelMask = 0;
     
-    auto lChoice = treeState.getRawParameterValue("l")->load();
-    auto lRChoice = treeState.getRawParameterValue("lr")->load();
-    auto rChoice = treeState.getRawParameterValue("r")->load();
+    for(int channel = 0; channel < maxChannels; ++channel)
+        if(valueOf(channelParams[(size_t) channel]) >= 0.5f)
+            newSettings.channelMask |= std::uint64_t (1) << channel;
     
-    if(lChoice == 1 && lRChoice == 0 && rChoice == 0)
-    {
-        routingChoice = -1;
-    }
-    if(lChoice == 0 && lRChoice == 1 && rChoice == 0)
-    {
-        routingChoice = 0;
-    }
-    if(lChoice == 0 && lRChoice == 0 && rChoice == 1)
-    {
-        routingChoice = 1;
-    }
-    
-    treeState.getRawParameterValue("hundred")->load();
-    treeState.getRawParameterValue("thousand")->load();
-    treeState.getRawParameterValue("tenThous")->load();
-    
-    treeState.getRawParameterValue("minus twenty")->load();
-    treeState.getRawParameterValue("minus twelve")->load();
-    treeState.getRawParameterValue("minus six")->load();
+    return newSettings;
 }
 
 //==============================================================================
@@ -207,69 +271,295 @@ double SIGAudioProcessor::getTailLengthSeconds() const
 
 int SIGAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return juce::jmax(1, (int) programs.size());   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+                                                    // so this should be at least 1, even if you're not really implementing programs.
 }
 
 int SIGAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load();
 }
 
+//Hosts call this from whatever thread they like, including the audio thread, so it only touches atomics.
+//The audio thread copies the program's precompiled Settings at the top of its next block, the timer then
+//moves the parameters over so the host and editor catch up. The index is checked against numPrograms, a bank
+//swapped in since can be shorter so the audio thread checks it again against the programs it has
 void SIGAudioProcessor::setCurrentProgram (int index)
 {
+    if(! juce::isPositiveAndBelow(index, numPrograms.load()))
+        return;
+    
+    currentProgram = index;
+    pendingProgram = index;
+    programToPublish = index;
 }
 
 const juce::String SIGAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return juce::isPositiveAndBelow(index, (int) programs.size()) ? programs[(size_t) index].name : juce::String();
 }
 
 void SIGAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    if(! juce::isPositiveAndBelow(index, (int) programs.size()))
+        return;
+    
+    presetBank.presets[(size_t) index].name = newName;
+    programs[(size_t) index].name = newName;
+}
+
+void SIGAudioProcessor::setPresetBank(const PresetBank& newBank)
+{
+    //everything is built before taking the lock, so the audio thread only ever waits for the swap
+    auto newPrograms = compilePrograms(newBank);
+    auto newPresetBank = newBank;
+    
+    {
+        const juce::ScopedLock sl(getCallbackLock());
+        std::swap(presetBank, newPresetBank);
+        std::swap(programs, newPrograms);
+        numPrograms = (int) programs.size();
+        pendingProgram = -1;
+        currentProgram = juce::jlimit(0, juce::jmax(0, (int) programs.size() - 1), currentProgram.load());
+    }
+    
+    updateHostDisplay();
+}
+
+juce::Result SIGAudioProcessor::loadPresetBank(const juce::File& file)
+{
+    PresetBank bank;
+    auto result = PresetBank::loadFromFile(file, bank);
+    
+    if(result.wasOk())
+        setPresetBank(bank);
+    
+    return result;
+}
+
+juce::Result SIGAudioProcessor::savePresetBank(const juce::File& file) const
+{
+    return presetBank.saveToFile(file);
+}
+
+void SIGAudioProcessor::setTestSequence(const TestSequence& newSequence)
+{
+    //copied before taking the lock so the audio thread only waits for the swap
+    auto sequence = newSequence;
+    
+    {
+        const juce::ScopedLock sl(getCallbackLock());
+        std::swap(testSequence, sequence);
+        sequencerRunning = false;
+    }
+}
+
+juce::Result SIGAudioProcessor::loadTestSequence(const juce::File& file)
+{
+    TestSequence sequence;
+    auto result = TestSequence::loadFromFile(file, sequence);
+    
+    if(result.wasOk())
+        setTestSequence(sequence);
+    
+    return result;
+}
+
+PresetBank SIGAudioProcessor::captureCurrentSettings(const juce::String& name) const
+{
+    PresetBank bank;
+    PresetBank::Preset preset;
+    preset.name = name;
+    
+    for(int i = 0; i < presetParameters.size(); ++i)
+    {
+        bank.parameterIDs.add(presetParameters[i]->paramID);
+        preset.values.push_back(presetParameterValues[i]->load());
+    }
+    
+    bank.presets.push_back(std::move(preset));
+    return bank;
+}
+
+//A few starting points, all with SIG switched off (the "bypass" parameter is the On button, 1 is on) so picking
+//one never makes a noise until it's switched on
+PresetBank SIGAudioProcessor::createFactoryBank() const
+{
+    PresetBank bank;
+    
+    for(auto* param : presetParameters)
+        bank.parameterIDs.add(param->paramID);
+    
+    auto addPreset = [&bank, this](const juce::String& name, std::initializer_list<std::pair<const char*, float>> values)
+    {
+        PresetBank::Preset preset;
+        preset.name = name;
+        
+        for(auto* param : presetParameters)
+            preset.values.push_back(param->convertFrom0to1(param->getDefaultValue()));
+        
+        preset.values[(size_t) bank.parameterIDs.indexOf("bypass")] = 0.0f;
+        
+        for(auto& value : values)
+        {
+            auto index = bank.parameterIDs.indexOf(value.first);
+            jassert(index >= 0);
+            
+            if(index >= 0)
+                preset.values[(size_t) index] = value.second;
+        }
+        
+        bank.presets.push_back(std::move(preset));
+    };
+    
+    addPreset("Sine 1 kHz -20 dB",      { { "signal", (float) sineSignal }, { "freq", 1000.0f }, { "gain", -20.0f } });
+    addPreset("Sine 100 Hz -20 dB",     { { "signal", (float) sineSignal }, { "freq", 100.0f },   { "gain", -20.0f } });
+    addPreset("Sine 10 kHz -20 dB",     { { "signal", (float) sineSignal }, { "freq", 10000.0f }, { "gain", -20.0f } });
+    addPreset("Sine 1 kHz -6 dB",       { { "signal", (float) sineSignal }, { "freq", 1000.0f }, { "gain", -6.0f } });
+    addPreset("White -20 dB",           { { "signal", (float) whiteSignal }, { "gain", -20.0f } });
+    addPreset("White Gaussian -12 dB",  { { "signal", (float) whiteSignal }, { "gaussian", 1.0f }, { "gain", -12.0f } });
+    addPreset("Pink -20 dB",            { { "signal", (float) pinkSignal }, { "gain", -20.0f } });
+    addPreset("Log Sweep 20 Hz-20 kHz", { { "signal", (float) sweepSignal }, { "sweepMode", 0.0f }, { "sweepStart", 20.0f }, { "sweepEnd", 20000.0f }, { "sweepTime", 10.0f }, { "gain", -20.0f } });
+    addPreset("Lin Sweep 20 Hz-20 kHz", { { "signal", (float) sweepSignal }, { "sweepMode", 1.0f }, { "sweepStart", 20.0f }, { "sweepEnd", 20000.0f }, { "sweepTime", 10.0f }, { "gain", -20.0f } });
+    addPreset("Multisine -12 dB",       { { "signal", (float) multisineSignal }, { "gain", -12.0f } });
+    addPreset("Saw 1 kHz -20 dB",       { { "signal", (float) sawSignal }, { "freq", 1000.0f }, { "gain", -20.0f } });
+    addPreset("Square 1 kHz -20 dB",    { { "signal", (float) squareSignal }, { "freq", 1000.0f }, { "gain", -20.0f } });
+    addPreset("Triangle 1 kHz -20 dB",  { { "signal", (float) triangleSignal }, { "freq", 1000.0f }, { "gain", -20.0f } });
+    addPreset("Pink Walk",              { { "signal", (float) pinkSignal }, { "routing", (float) routeWalk }, { "gain", -20.0f } });
+    
+    return bank;
+}
+
+//Values go through each parameter's range and back so they're clamped and snapped exactly like the host
+//would, parameters the bank doesn't have get their default
+std::vector<SIGAudioProcessor::Program> SIGAudioProcessor::compilePrograms(const PresetBank& bank) const
+{
+    std::vector<Program> compiled;
+    compiled.reserve((size_t) bank.size());
+    std::vector<float> values((size_t) presetParameters.size());
+    
+    for(int presetIndex = 0; presetIndex < bank.size(); ++presetIndex)
+    {
+        Program program;
+        program.name = bank.presets[(size_t) presetIndex].name;
+        
+        for(int i = 0; i < presetParameters.size(); ++i)
+        {
+            auto* param = presetParameters[i];
+            auto value = bank.getValue(presetIndex, param->paramID, param->convertFrom0to1(param->getDefaultValue()));
+            auto normalised = param->convertTo0to1(value);
+            
+            program.normalisedValues.push_back(normalised);
+            values[(size_t) i] = param->convertFrom0to1(normalised);
+        }
+        
+        program.settings = makeSettings([this, &values](std::atomic<float>* param)
+        {
+            auto index = presetParameterValues.indexOf(param);
+            return index >= 0 ? values[(size_t) index] : param->load();
+        });
+        
+        compiled.push_back(std::move(program));
+    }
+    
+    return compiled;
+}
+
+void SIGAudioProcessor::publishProgram(int index)
+{
+    if(! juce::isPositiveAndBelow(index, (int) programs.size()))
+        return;
+    
+    auto& values = programs[(size_t) index].normalisedValues;
+    
+    for(int i = 0; i < presetParameters.size(); ++i)
+        if(presetParameters[i]->getValue() != values[(size_t) i])
+            presetParameters[i]->setValueNotifyingHost(values[(size_t) i]);
+    
+    updateHostDisplay();
+}
+
+void SIGAudioProcessor::applyPresetValues(const PresetBank& bank, int presetIndex)
+{
+    for(auto* param : presetParameters)
+    {
+        auto value = bank.getValue(presetIndex, param->paramID, param->convertFrom0to1(param->getDefaultValue()));
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+}
+
+void SIGAudioProcessor::timerCallback()
+{
+    publishProgram(programToPublish.exchange(-1));
 }
 
 //==============================================================================
 void SIGAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.sampleRate = sampleRate;
-    spec.numChannels = getTotalNumOutputChannels();
+    settings = readSettings();
+    parameterSettings = settings;
+    playing = settings;
+    
+    //mono scratch the generators render into before it's routed to the outputs
+    signalBuffer.setSize(1, juce::jmax(samplesPerBlock, 1));
+    doubleSignalBuffer.setSize(1, signalBuffer.getNumSamples());
     
     gain.reset(sampleRate, 0.1f);
-    gain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(treeState.getRawParameterValue("gain")->load()));
+    gain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(settings.gainDecibels));
+    gainRamp.allocate(signalBuffer.getNumSamples(), true);
     
-    osc.prepare(spec);
-    osc.setFrequency(treeState.getRawParameterValue("freq")->load());
+    osc.prepare(sampleRate, signalBuffer.getNumSamples());
+    osc.setFrequency(settings.frequency);
+    osc.setCacheEnabled(settings.sineCache);
     
-    panner.reset();
-    panner.prepare(spec);
-    panner.setRule(juce::dsp::PannerRule::balanced); // L, L+R, R are all the same volume
-        
-    treeState.getRawParameterValue("sine")->load();
-    treeState.getRawParameterValue("white")->load();
-    treeState.getRawParameterValue("pink")->load();
+    sweep.setParameters(settings.sweep);
+    sweep.prepare(sampleRate);
     
-    treeState.getRawParameterValue("l")->load();
-    treeState.getRawParameterValue("lr")->load();
-    treeState.getRawParameterValue("r")->load();
+    shapeOsc.prepare(sampleRate);
+    
+    //prepareToPlay can allocate so the first table is built right here
+    multisine.prepare(sampleRate, Multisine::createTable(getMultisineTones(), sampleRate));
+    
+    whiteNoise.prepare(getTotalNumOutputChannels(), noiseSeed + 1);
+    
+    //equal power crossfade curves, sample p of a fade is in at sin and out at cos of (p + 1) / fadeLength quarter turns
+    fadeLength = juce::jmax(1, juce::roundToInt(fadeSeconds * sampleRate));
+    fadeInCurve.allocate((size_t) fadeLength, false);
+    fadeOutCurve.allocate((size_t) fadeLength, false);
+    
+    for(int i = 0; i < fadeLength; ++i)
+    {
+        auto angle = juce::MathConstants<double>::halfPi * (double) (i + 1) / (double) fadeLength;
+        fadeInCurve[i] = (float) std::sin(angle);
+        fadeOutCurve[i] = (float) std::cos(angle);
+    }
     
-    treeState.getRawParameterValue("hundred")->load();
-    treeState.getRawParameterValue("thousand")->load();
-    treeState.getRawParameterValue("tenThous")->load();
+    auto numBufferChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+    fadeBuffer.setSize(numBufferChannels, signalBuffer.getNumSamples());
+    doubleFadeBuffer.setSize(numBufferChannels, signalBuffer.getNumSamples());
+    fadeSamplesLeft = 0;
     
-    treeState.getRawParameterValue("minus twenty")->load();
-    treeState.getRawParameterValue("minus twelve")->load();
-    treeState.getRawParameterValue("minus six")->load();
+    walkChannel = 0;
+    walkSamplesLeft = getWalkPeriod();
     
-    bypass = treeState.getRawParameterValue("bypass")->load();
+   #if SIG_BLOCK_TIMING
+    blockTimer.prepare(sampleRate, samplesPerBlock);
+   #endif
+    
+    //a bounce plays the sequence from the top
+    sequencerRunning = false;
 }
 
 void SIGAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    sharedSignal.unsubscribe();
+    
+   #if SIG_BLOCK_TIMING
+    if(juce::File::isAbsolutePath(blockTimingFile) && blockTimer.getSnapshot().numBlocks > 0)
+        writeBlockTiming(juce::File(blockTimingFile));
+   #endif
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -279,12 +569,10 @@ bool SIGAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) cons
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Anything from mono up to 64 channels, speaker layouts or discrete
+    auto numOutputs = layouts.getMainOutputChannelSet().size();
+    
+    if (numOutputs < 1 || numOutputs > maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -298,7 +586,30 @@ bool SIGAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) cons
 }
 #endif
 
+bool SIGAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+//float and double blocks go through the same code, hosts with a 64 bit engine don't have to convert every buffer
 void SIGAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+   #if SIG_BLOCK_TIMING
+    const BlockTimer::ScopedBlock timing(blockTimer, buffer.getNumSamples());
+   #endif
+    processSamples(buffer, midiMessages);
+}
+
+void SIGAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+   #if SIG_BLOCK_TIMING
+    const BlockTimer::ScopedBlock timing(blockTimer, buffer.getNumSamples());
+   #endif
+    processSamples(buffer, midiMessages);
+}
+
+template <typename SampleType>
+void SIGAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -307,139 +618,733 @@ void SIGAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Mi
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    //Target value of gain coming from gain slider
-    gain.setTargetValue(juce::Decibels::decibelsToGain(treeState.getRawParameterValue("gain")->load()));
+    auto numSamples = buffer.getNumSamples();
+    
+    //parameters are read once per block, hosts don't say where in the block automation landed so a change
+    //takes effect from the first sample. Only parameters that moved are applied so MIDI changes stick
+    auto newParameterSettings = readSettings();
+    mergeParameterChanges(settings, parameterSettings, newParameterSettings);
+    parameterSettings = newParameterSettings;
+    
+    //a program change replaces the lot, its parameter values follow from the message thread and are the same
+    //as the program's so merging them in later blocks changes nothing
+    auto program = pendingProgram.exchange(-1);
     
-    auto lChoice = treeState.getRawParameterValue("l")->load();
-    auto lRChoice = treeState.getRawParameterValue("lr")->load();
-    auto rChoice = treeState.getRawParameterValue("r")->load();
+    if(juce::isPositiveAndBelow(program, (int) programs.size()))
+        settings = programs[(size_t) program].settings;
     
-    if(lChoice == 1 && lRChoice == 0 && rChoice == 0)
+    //switching the sequencer off goes back to what the parameters say
+    if(sequencerRunning && ! settings.sequencer)
     {
-        routingChoice = 0;
+        settings = newParameterSettings;
+        sequencerRunning = false;
     }
-    if(lChoice == 0 && lRChoice == 1 && rChoice == 0)
+    
+    applySettings();
+    
+    events.clear();
+    
+    //the sequencer's steps go in first so MIDI can't crowd them out of the event list
+    if(settings.sequencer)
+        collectSequenceEvents(numSamples);
+    
+    if(settings.midiControl)
+        collectMidiEvents(midiMessages, numSamples);
+    
+    //both lists are in time order, an insertion sort merges them without allocating and keeps a step ahead of
+    //MIDI on the same sample
+    for(size_t i = 1; i < events.size(); ++i)
+        for(auto j = i; j > 0 && events[j - 1].sampleOffset > events[j].sampleOffset; --j)
+            std::swap(events[j - 1], events[j]);
+    
+    //fast path, nothing changes partway through so the whole block renders in one go
+    if(events.empty())
     {
-        routingChoice = 1;
+        renderSegment(buffer, 0, numSamples);
     }
-    if(lChoice == 0 && lRChoice == 0 && rChoice == 1)
+    else
     {
-        routingChoice = 2;
+        //otherwise the block is split at every event and each piece renders with the settings at that sample
+        int start = 0;
+        
+        for(auto& event : events)
+        {
+            if(event.sampleOffset > start)
+            {
+                renderSegment(buffer, start, event.sampleOffset - start);
+                start = event.sampleOffset;
+            }
+            
+            applyEvent(event);
+            applySettings();
+        }
+        
+        renderSegment(buffer, start, numSamples - start);
     }
     
-    // panner L, L+R, R choices coming from panRoutingFunc
-    panner.setPan(panRoutingFunc(routingChoice));
+    outputMeter.push(buffer);
+}
+
+//Copies over the parameters that changed between two snapshots and leaves the rest of target alone
+void SIGAudioProcessor::mergeParameterChanges(Settings& target, const Settings& before, const Settings& after)
+{
+    if(after.gainDecibels != before.gainDecibels)   target.gainDecibels = after.gainDecibels;
+    if(after.frequency != before.frequency)         target.frequency = after.frequency;
+    if(after.bypass != before.bypass)               target.bypass = after.bypass;
+    if(after.gaussian != before.gaussian)           target.gaussian = after.gaussian;
+    if(after.sineCache != before.sineCache)         target.sineCache = after.sineCache;
+    if(after.signalType != before.signalType)       target.signalType = after.signalType;
+    if(after.routingChoice != before.routingChoice) target.routingChoice = after.routingChoice;
+    if(after.channelMask != before.channelMask)     target.channelMask = after.channelMask;
+    if(after.walkSeconds != before.walkSeconds)     target.walkSeconds = after.walkSeconds;
+    if(after.pulseWidth != before.pulseWidth)       target.pulseWidth = after.pulseWidth;
+    if(after.midiControl != before.midiControl)     target.midiControl = after.midiControl;
+    if(after.shared != before.shared)               target.shared = after.shared;
+    if(after.sequencer != before.sequencer)         target.sequencer = after.sequencer;
+    if(after.sweep != before.sweep)                 target.sweep = after.sweep;
+}
+
+//MIDI with MIDI Control on: note on sets the frequency, CC 7 the gain (0 to 127 is -120 to 0 dB)
+//and program change the signal type. MidiBuffer is in time order so the events come out sorted
+void SIGAudioProcessor::collectMidiEvents(const juce::MidiBuffer& midiMessages, int numSamples)
+{
+    for(const auto metadata : midiMessages)
+    {
+        if((int) events.size() >= maxEventsPerBlock)
+            break;
+        
+        auto message = metadata.getMessage();
+        auto offset = juce::jlimit(0, juce::jmax(numSamples - 1, 0), metadata.samplePosition);
+        
+        if(message.isNoteOn())
+            events.push_back({ offset, Event::Type::frequency, (float) juce::MidiMessage::getMidiNoteInHertz(message.getNoteNumber()) });
+        else if(message.isControllerOfType(7))
+            events.push_back({ offset, Event::Type::gain, juce::jmap((float) message.getControllerValue(), 0.0f, 127.0f, -120.0f, 0.0f) });
+        else if(message.isProgramChange())
+            events.push_back({ offset, Event::Type::signal, (float) (message.getProgramChangeNumber() % numSignalTypes) });
+    }
+}
+
+//Step changes for the samples of this block. The first block after the Sequencer parameter goes on (or after
+//prepareToPlay or a new list) starts the first step on its first sample. Steps are at least 10ms so even a huge
+//offline block stays well under maxEventsPerBlock
+void SIGAudioProcessor::collectSequenceEvents(int numSamples)
+{
+    const auto& steps = testSequence.steps;
+    
+    if(steps.empty())
+        return;
+    
+    if(! sequencerRunning)
+    {
+        sequencerRunning = true;
+        sequenceStep = -1;
+        sequencePosition = 0;
+        nextStepPosition = 0;
+        nextStepSeconds = 0.0;
+    }
+    
+    auto blockEnd = sequencePosition + numSamples;
+    
+    while(nextStepPosition < blockEnd && (int) events.size() < maxEventsPerBlock)
+    {
+        auto offset = (int) juce::jmax((std::int64_t) 0, nextStepPosition - sequencePosition);
+        
+        if(++sequenceStep >= (int) steps.size())
+        {
+            //past the last step SIG goes off, until the list is looped or the sequencer is switched off and on
+            if(! testSequence.loop)
+            {
+                events.push_back({ offset, Event::Type::step, -1.0f });
+                nextStepPosition = std::numeric_limits<std::int64_t>::max();
+                break;
+            }
+            
+            sequenceStep = 0;
+        }
+        
+        events.push_back({ offset, Event::Type::step, (float) sequenceStep });
+        
+        //step ends are worked out from the total time so far, rounding doesn't build up over a long list
+        nextStepSeconds += steps[(size_t) sequenceStep].seconds;
+        nextStepPosition = (std::int64_t) std::llround(nextStepSeconds * getSampleRate());
+    }
     
-    //oscillator frequency
-    osc.setFrequency(*treeState.getRawParameterValue("freq"));
+    sequencePosition = blockEnd;
+}
 
-    //My dsp object
-    juce::dsp::AudioBlock<float> block { buffer };
+//A step sets the signal, frequency, gain and routing like MIDI does, they hold until the step after or until
+//the parameter itself is moved. -1 is the end of the list
+void SIGAudioProcessor::applyStep(int stepIndex)
+{
+    if(! juce::isPositiveAndBelow(stepIndex, (int) testSequence.steps.size()))
+    {
+        settings.bypass = false;
+        return;
+    }
+    
+    const auto& step = testSequence.steps[(size_t) stepIndex];
     
-    auto sineChoice = treeState.getRawParameterValue("sine")->load();
-    auto whiteChoice = treeState.getRawParameterValue("white")->load();
-    auto pinkChoice = treeState.getRawParameterValue("pink")->load();
+    //a step coming out of silence starts at its level, the gain ramp would still be on its way from the level
+    //before the gap. Between two steps that both sound it ramps over 100ms the same as the Gain control
+    if(step.on && ! settings.bypass)
+        gain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(step.gainDecibels));
     
-    if(sineChoice == 1 && whiteChoice == 0 && pinkChoice == 0)
+    settings.bypass = step.on;
+    settings.signalType = step.signalType;
+    settings.frequency = step.frequency;
+    settings.gainDecibels = step.gainDecibels;
+    settings.routingChoice = step.routing;
+}
+
+void SIGAudioProcessor::applyEvent(const Event& event)
+{
+    switch(event.type)
     {
-        signalType = 0;
+        case Event::Type::frequency: settings.frequency = juce::jlimit(20.0f, 21000.0f, event.value); break;
+        case Event::Type::gain:      settings.gainDecibels = event.value; break;
+        case Event::Type::signal:    settings.signalType = (int) event.value; break;
+        case Event::Type::step:      applyStep((int) event.value); break;
     }
-    if(sineChoice == 0 && whiteChoice == 1 && pinkChoice == 0)
+}
+
+//Pushes the current settings into the generators, at the top of the block, again after every event and when a
+//fade ends with a switch waiting
+void SIGAudioProcessor::applySettings()
+{
+    auto previous = playing;
+    playing = settings;
+    
+    //a fade always runs to the end, the signal, routing and on/off stay put till then (the latest change wins)
+    //and everything else applies straight away
+    if(fadeSamplesLeft > 0)
     {
-        signalType = 1;
+        playing.bypass = previous.bypass;
+        playing.signalType = previous.signalType;
+        playing.routingChoice = previous.routingChoice;
+        playing.channelMask = previous.channelMask;
     }
-    if(sineChoice == 0 && whiteChoice == 0 && pinkChoice == 1)
+    
+    //a change of signal, routing or on/off fades from what was playing
+    auto routingChanged = playing.routingChoice != previous.routingChoice
+                       || (playing.channelMask != previous.channelMask && playing.routingChoice >= routeCustom);
+    
+    if(playing.bypass != previous.bypass
+        || (playing.bypass && (playing.signalType != previous.signalType || routingChanged)))
     {
-        signalType = 2;
+        fadeFrom.on = previous.bypass;
+        fadeFrom.signalType = previous.signalType;
+        fadeFrom.routingChoice = previous.routingChoice;
+        fadeFrom.routedChannels = getRoutedChannels(previous.routingChoice, previous.channelMask);
+        fadeShapeOsc = shapeOsc;
+        fadePosition = 0;
+        fadeSamplesLeft = fadeLength;
     }
     
-    //bypass if statement
-    if(!bypass){} // if true, do nothing
-    else //if false process osc, white, pink depending on signalType chosen
+    //the sweep starts from the top when it's picked or SIG is switched on, and when any sweep parameter changes
+    auto sweepStarting = playing.signalType == sweepSignal && playing.bypass
+                      && (previous.signalType != sweepSignal || ! previous.bypass);
+    
+    sweep.setParameters(playing.sweep);
+    
+    if(sweepStarting)
+        sweep.reset();
+    
+    //Target value of gain coming from gain slider
+    gain.setTargetValue(juce::Decibels::decibelsToGain(playing.gainDecibels));
+    
+    //oscillator frequency, a change takes the sine off its cached loop
+    osc.setFrequency(playing.frequency);
+    osc.setCacheEnabled(playing.sineCache);
+    
+    //the saw, square and triangle share one oscillator and follow the same frequency
+    if(playing.signalType == sawSignal)      shapeOsc.setWaveform(BandLimitedOscillator::Waveform::saw);
+    if(playing.signalType == squareSignal)   shapeOsc.setWaveform(BandLimitedOscillator::Waveform::square);
+    if(playing.signalType == triangleSignal) shapeOsc.setWaveform(BandLimitedOscillator::Waveform::triangle);
+    
+    shapeOsc.setFrequency(playing.frequency);
+    shapeOsc.setPulseWidth(playing.pulseWidth);
+    
+    whiteNoise.setDistribution(playing.gaussian ? WhiteNoiseBank::Distribution::gaussian
+                                                : WhiteNoiseBank::Distribution::uniform);
+    
+    //shared engine, instances playing the same thing read one process-wide generator (SharedGenerators.h).
+    //If the pool is full the instance carries on with its own generators
+    auto shape = SharedGeneratorPool::Shape::sine;
+    auto shareable = true;
+    
+    switch(playing.signalType)
+    {
+        case sineSignal:     shape = SharedGeneratorPool::Shape::sine; break;
+        case pinkSignal:     shape = SharedGeneratorPool::Shape::pink; break;
+        case sawSignal:      shape = SharedGeneratorPool::Shape::saw; break;
+        case squareSignal:   shape = SharedGeneratorPool::Shape::square; break;
+        case triangleSignal: shape = SharedGeneratorPool::Shape::triangle; break;
+        default:             shareable = false; break;
+    }
+    
+    if(playing.shared && playing.bypass && shareable)
     {
-        switch (signalType)
+        auto usesFrequency = playing.signalType != pinkSignal;
+        
+        sharedSignal.subscribe(shape, { playing.signalType,
+                                        usesFrequency ? playing.frequency : 0.0f,
+                                        playing.signalType == squareSignal ? playing.pulseWidth : 0.0f,
+                                        getSampleRate() });
+    }
+    else
+    {
+        sharedSignal.unsubscribe();
+    }
+}
+
+//Renders numSamples from startSample, the whole block when there are no events
+template <typename SampleType>
+void SIGAudioProcessor::renderSegment(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+{
+    if(fadeSamplesLeft > 0)
+    {
+        auto numFading = juce::jmin(numSamples, fadeSamplesLeft);
+        renderCrossfade(buffer, startSample, numFading);
+        
+        startSample += numFading;
+        numSamples -= numFading;
+        
+        //a switch that came in during the fade starts its own from here
+        if(fadeSamplesLeft == 0 && isSwitchWaiting())
         {
-            case 0: oscProcess(buffer); break;
-            case 1: whiteNoiseProcess(buffer); break;
-            case 2: pinkNoiseProcess(buffer); break;
-            default: oscProcess(buffer); break;
+            applySettings();
+            renderSegment(buffer, startSample, numSamples);
+            return;
         }
-        panner.process(juce::dsp::ProcessContextReplacing<float> (block));
     }
+    
+    renderSettings(buffer, startSample, numSamples);
 }
 
-//Function returns value for panner.setPan in process block
-float SIGAudioProcessor::panRoutingFunc(int choice)
+bool SIGAudioProcessor::isSwitchWaiting() const noexcept
 {
-    switch (choice)
+    return playing.bypass != settings.bypass || playing.signalType != settings.signalType
+        || playing.routingChoice != settings.routingChoice || playing.channelMask != settings.channelMask;
+}
+
+//Renders with the playing settings
+template <typename SampleType>
+void SIGAudioProcessor::renderSettings(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+{
+    //bypass if statement
+    if(!playing.bypass){} // if true, do nothing
+    else //if false render the chosen signal type and routing
     {
-        case 0:
-            return -1.0f;
-            break;
-        case 1:
-            return 0.0f;
-            break;
-        case 2:
-            return 1.0f;
-            break;
-        default:
-            return 0.0f;
-            break;
+        auto endSample = startSample + numSamples;
+        auto numChannels = buffer.getNumChannels();
+        auto maxChunk = signalBuffer.getNumSamples();
+        auto kernel = getRenderKernel<SampleType>(playing.signalType, playing.routingChoice, numChannels);
+        auto isWalking = playing.routingChoice == routeWalk;
+        
+        if(isWalking)
+        {
+            //a shorter walk time or a channel being switched off takes effect straight away
+            walkSamplesLeft = juce::jmin(walkSamplesLeft, getWalkPeriod());
+            
+            if(((getEnabledChannels(numChannels) >> walkChannel) & 1) == 0)
+                walkChannel = getNextWalkChannel(numChannels);
+            
+            routingMask = std::uint64_t (1) << walkChannel;
+        }
+        else
+        {
+            routingMask = playing.channelMask;
+        }
+        
+        // hosts can send bigger blocks than prepareToPlay said so it goes in chunks of the scratch size,
+        // walk mode also splits a chunk where it moves on to the next channel
+        for(int start = startSample; start < endSample;)
+        {
+            auto chunk = juce::jmin(maxChunk, endSample - start);
+            
+            if(isWalking)
+                chunk = juce::jmin(chunk, walkSamplesLeft);
+            
+            (this->*kernel)(buffer, start, chunk);
+            start += chunk;
+            
+            if(isWalking && (walkSamplesLeft -= chunk) <= 0)
+            {
+                walkChannel = getNextWalkChannel(numChannels);
+                walkSamplesLeft = getWalkPeriod();
+                routingMask = std::uint64_t (1) << walkChannel;
+            }
+        }
     }
 }
-//Function for oscillator processing
-void SIGAudioProcessor::oscProcess(juce::AudioBuffer<float> &buffer)
+
+//Equal power crossfade from fadeFrom to the playing settings.
+//The old output is rendered into fadeBuffer with the old kernel, or copied from the block if SIG was off (the input
+//passes through then), the new one goes into the block as usual and the two are mixed with the fade curves.
+//Both kernels run the gain smoother over the same samples so it's put back in between. When only the routing of the
+//same signal changes there's only one generator, so it's rendered once to every channel either routing uses and the
+//channels that are only in one of them are faded in or out
+template <typename SampleType>
+void SIGAudioProcessor::renderCrossfade(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
 {
-    auto block = juce::dsp::AudioBlock<float> (buffer);
+    auto& oldOutput = getFadeScratch<SampleType>();
+    auto numChannels = buffer.getNumChannels();
     
-    osc.process(juce::dsp::ProcessContextReplacing<float> (block));
+    //a host sending more channels than prepareToPlay said just gets the hard switch
+    if(oldOutput.getNumChannels() != numChannels)
+    {
+        fadeSamplesLeft = 0;
+        renderSettings(buffer, startSample, numSamples);
+        return;
+    }
+    
+    auto sameSignal = fadeFrom.on && playing.bypass && fadeFrom.signalType == playing.signalType;
+    
+    for(int done = 0; done < numSamples;)
+    {
+        auto chunk = juce::jmin(numSamples - done, oldOutput.getNumSamples());
+        auto start = startSample + done;
+        const auto* in = fadeInCurve.get() + fadePosition;
+        const auto* out = fadeOutCurve.get() + fadePosition;
         
-    for(int channel = 0; channel < block.getNumChannels(); ++channel)
+        if(sameSignal)
+        {
+            auto newChannels = getRoutedChannels(playing.routingChoice, playing.channelMask);
+            
+            routingMask = fadeFrom.routedChannels | newChannels;
+            (this->*getRenderKernel<SampleType>(playing.signalType, routeCustom, numChannels))(buffer, start, chunk);
+            
+            for(int channel = 0; channel < juce::jmin(numChannels, maxChannels); ++channel)
+            {
+                auto wasRouted = ((fadeFrom.routedChannels >> channel) & 1) != 0;
+                auto isRouted = ((newChannels >> channel) & 1) != 0;
+                
+                if(wasRouted == isRouted)
+                    continue;
+                
+                auto* dest = buffer.getWritePointer(channel, start);
+                const auto* curve = isRouted ? in : out;
+                
+                for(int i = 0; i < chunk; ++i)
+                    dest[i] *= (SampleType) curve[i];
+            }
+        }
+        else
+        {
+            if(fadeFrom.on)
+            {
+                auto gainState = gain;
+                
+                std::swap(shapeOsc, fadeShapeOsc);
+                renderingFadeOut = true;
+                routingMask = fadeFrom.routedChannels;
+                
+                (this->*getRenderKernel<SampleType>(fadeFrom.signalType, fadeFrom.routingChoice, numChannels))(oldOutput, 0, chunk);
+                
+                renderingFadeOut = false;
+                std::swap(shapeOsc, fadeShapeOsc);
+                gain = gainState;
+            }
+            else
+            {
+                for(int channel = 0; channel < numChannels; ++channel)
+                    oldOutput.copyFrom(channel, 0, buffer, channel, start, chunk);
+            }
+            
+            renderSettings(buffer, start, chunk);
+            
+            //fading to off renders nothing new, the smoother still has to move on over these samples
+            if(! playing.bypass)
+                gain.skip(chunk);
+            
+            for(int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* dest = buffer.getWritePointer(channel, start);
+                const auto* old = oldOutput.getReadPointer(channel);
+                
+                for(int i = 0; i < chunk; ++i)
+                    dest[i] = dest[i] * (SampleType) in[i] + old[i] * (SampleType) out[i];
+            }
+        }
+        
+        fadePosition += chunk;
+        fadeSamplesLeft -= chunk;
+        done += chunk;
+    }
+}
+
+template <typename SampleType>
+juce::AudioBuffer<SampleType>& SIGAudioProcessor::getFadeScratch()
+{
+    if constexpr (std::is_same<SampleType, float>::value)
+        return fadeBuffer;
+    else
+        return doubleFadeBuffer;
+}
+
+//Channels a routing sends the signal to, bit n is channel n. Walk is the channel it's on now
+std::uint64_t SIGAudioProcessor::getRoutedChannels(int routingChoice, std::uint64_t channelMask) const
+{
+    switch(routingChoice)
     {
-        auto* channelData = block.getChannelPointer(channel);
+        case routeL:    return 1;
+        case routeR:    return 2;
+        case routeLR:   return ~std::uint64_t (0);
+        case routeWalk: return std::uint64_t (1) << walkChannel;
+        default:        return channelMask;
+    }
+}
 
-        for(int sample = 0; sample < block.getNumSamples(); ++sample)
+//Render kernels
+//Each one is a single signal type, routing and channel count (NumChannels 0 means any count), so which generator runs
+//and which channels get the signal are known at compile time and the loops have no branches in them.
+//A new waveform or routing is a new case in the if constexpr chains plus a row or column in getRenderKernel.
+//Float and double blocks get their own set, the noise and the multisine are float generators and get widened for double
+template <typename SampleType, int Signal, int Route, int NumChannels>
+void SIGAudioProcessor::renderKernel(juce::AudioBuffer<SampleType> &buffer, int startSample, int numSamples)
+{
+    const auto numChannels = NumChannels > 0 ? NumChannels : buffer.getNumChannels();
+    
+    const auto mask = routingMask;
+    
+    auto isRouted = [&](int channel)
+    {
+        if constexpr (Route == routeL)      return channel == 0;
+        if constexpr (Route == routeR)      return channel == 1;
+        if constexpr (Route == routeLR)     return true;
+        if constexpr (Route == routeCustom) return channel < maxChannels && ((mask >> channel) & 1) != 0;
+    };
+    
+    gainRampProcess(numSamples);
+    
+    if constexpr (Signal == whiteSignal)
+    {
+        // white noise gets its own stream per routed output so the channels are decorrelated
+        for(int channel = 0; channel < numChannels; ++channel)
+        {
+            if(isRouted(channel) && channel < whiteNoise.getNumChannels())
+            {
+                auto* channelData = buffer.getWritePointer(channel, startSample);
+                renderFloatGenerator(channelData, numSamples, [&](float* dest, int num) { whiteNoise.process(channel, dest, num); });
+                gainProcess(channelData, numSamples);
+            }
+            else
+            {
+                buffer.clear(channel, startSample, numSamples);
+            }
+        }
+    }
+    else
+    {
+        // everything but white noise is rendered once in mono and then copied to the routed outputs, so 64 channels costs
+        // one generator plus the copies
+        auto* signal = getSignalScratch<SampleType>();
+        
+        constexpr auto shareable = Signal == sineSignal || Signal == pinkSignal || Signal == sawSignal || Signal == squareSignal || Signal == triangleSignal;
+        
+        if(shareable && sharedSignal.isSubscribed() && ! renderingFadeOut)
+        {
+            renderFloatGenerator(signal, numSamples, [&](float* dest, int num) { sharedSignal.read(dest, num); });
+        }
+        else
         {
-            channelData[sample] *= gain.getNextValue();
+            if constexpr (Signal == sineSignal) osc.process(signal, numSamples);
+            if constexpr (Signal == pinkSignal) renderFloatGenerator(signal, numSamples, [&](float* dest, int num) { pink.process(dest, num); });
+            if constexpr (Signal == sweepSignal) sweep.process(signal, numSamples);
+            if constexpr (Signal == multisineSignal) renderFloatGenerator(signal, numSamples, [&](float* dest, int num) { multisine.process(dest, num); });
+            if constexpr (Signal == sawSignal || Signal == squareSignal || Signal == triangleSignal) shapeOsc.process(signal, numSamples);
+        }
+        
+        gainProcess(signal, numSamples);
+        
+        for(int channel = 0; channel < numChannels; ++channel)
+        {
+            if(isRouted(channel))
+                juce::FloatVectorOperations::copy(buffer.getWritePointer(channel, startSample), signal, numSamples);
+            else
+                buffer.clear(channel, startSample, numSamples);
         }
     }
 }
 
-//Function for white noise processing
-void SIGAudioProcessor::whiteNoiseProcess(juce::AudioBuffer<float> &buffer)
+template <typename SampleType, int Signal, int Route>
+SIGAudioProcessor::ChannelKernels<SampleType> SIGAudioProcessor::makeChannelKernels()
+{
+    return {{ &SIGAudioProcessor::renderKernel<SampleType, Signal, Route, 1>,
+              &SIGAudioProcessor::renderKernel<SampleType, Signal, Route, 2>,
+              &SIGAudioProcessor::renderKernel<SampleType, Signal, Route, 0> }};
+}
+
+//Function returns the kernel for the signal type, routing and channel count
+template <typename SampleType>
+SIGAudioProcessor::RenderKernel<SampleType> SIGAudioProcessor::getRenderKernel(int signalType, int routingChoice, int numChannels)
 {
-    auto block = juce::dsp::AudioBlock<float> (buffer);
+    //walk is the custom kernel with a one channel mask
+    static const ChannelKernels<SampleType> kernels[numSignalTypes][numRoutings] =
+    {
+        { makeChannelKernels<SampleType, sineSignal, routeL>(),  makeChannelKernels<SampleType, sineSignal, routeLR>(),  makeChannelKernels<SampleType, sineSignal, routeR>(),
+          makeChannelKernels<SampleType, sineSignal, routeCustom>(),  makeChannelKernels<SampleType, sineSignal, routeCustom>() },
+        { makeChannelKernels<SampleType, whiteSignal, routeL>(), makeChannelKernels<SampleType, whiteSignal, routeLR>(), makeChannelKernels<SampleType, whiteSignal, routeR>(),
+          makeChannelKernels<SampleType, whiteSignal, routeCustom>(), makeChannelKernels<SampleType, whiteSignal, routeCustom>() },
+        { makeChannelKernels<SampleType, pinkSignal, routeL>(),  makeChannelKernels<SampleType, pinkSignal, routeLR>(),  makeChannelKernels<SampleType, pinkSignal, routeR>(),
+          makeChannelKernels<SampleType, pinkSignal, routeCustom>(),  makeChannelKernels<SampleType, pinkSignal, routeCustom>() },
+        { makeChannelKernels<SampleType, sweepSignal, routeL>(), makeChannelKernels<SampleType, sweepSignal, routeLR>(), makeChannelKernels<SampleType, sweepSignal, routeR>(),
+          makeChannelKernels<SampleType, sweepSignal, routeCustom>(), makeChannelKernels<SampleType, sweepSignal, routeCustom>() },
+        { makeChannelKernels<SampleType, multisineSignal, routeL>(), makeChannelKernels<SampleType, multisineSignal, routeLR>(), makeChannelKernels<SampleType, multisineSignal, routeR>(),
+          makeChannelKernels<SampleType, multisineSignal, routeCustom>(), makeChannelKernels<SampleType, multisineSignal, routeCustom>() },
+        { makeChannelKernels<SampleType, sawSignal, routeL>(),  makeChannelKernels<SampleType, sawSignal, routeLR>(),  makeChannelKernels<SampleType, sawSignal, routeR>(),
+          makeChannelKernels<SampleType, sawSignal, routeCustom>(),  makeChannelKernels<SampleType, sawSignal, routeCustom>() },
+        { makeChannelKernels<SampleType, squareSignal, routeL>(), makeChannelKernels<SampleType, squareSignal, routeLR>(), makeChannelKernels<SampleType, squareSignal, routeR>(),
+          makeChannelKernels<SampleType, squareSignal, routeCustom>(), makeChannelKernels<SampleType, squareSignal, routeCustom>() },
+        { makeChannelKernels<SampleType, triangleSignal, routeL>(), makeChannelKernels<SampleType, triangleSignal, routeLR>(), makeChannelKernels<SampleType, triangleSignal, routeR>(),
+          makeChannelKernels<SampleType, triangleSignal, routeCustom>(), makeChannelKernels<SampleType, triangleSignal, routeCustom>() }
+    };
+    
+    auto channelIndex = numChannels == 1 ? 0 : (numChannels == 2 ? 1 : 2);
     
-    for(int channel = 0; channel < block.getNumChannels(); ++channel)
+    return kernels[signalType][routingChoice][channelIndex];
+}
+
+juce::AudioBuffer<float> SIGAudioProcessor::createSweepInverseFilter() const
+{
+    SineSweep inverseSweep;
+    inverseSweep.setParameters(readSettings().sweep);
+    inverseSweep.prepare(getSampleRate() > 0.0 ? getSampleRate() : 44100.0);
+    
+    return inverseSweep.createInverseFilter();
+}
+
+//Any thread, the renderer calls it from its workers. The tones only live here under multisineLock,
+//getStateInformation writes them out, nothing touches the ValueTree from here
+void SIGAudioProcessor::setMultisineTones(const juce::Array<Multisine::Tone>& tones)
+{
     {
-        auto* channelData = block.getChannelPointer(channel);
+        const juce::ScopedLock sl(multisineLock);
+        multisineTones = tones;
+    }
+    
+    multisineBuilder.requestTable(tones, getSampleRate());
+}
 
-        for(int sample = 0; sample < block.getNumSamples(); ++sample)
-        {
-            //channelData[sample] = ((float)rand()/RAND_MAX) * 2.0f - 1.0f; // white noise from a forum post - need something to compare this to
-            channelData[sample] = random.nextFloat(); // from JUCE tutorial, seems the same as above but a bit quieter
-            channelData[sample] *= gain.getNextValue();
-        }
+void SIGAudioProcessor::setNoiseSeed(std::uint64_t seed)
+{
+    noiseSeed = seed;
+    pink.setSeed(noiseSeed);
+    whiteNoise.prepare(whiteNoise.getNumChannels(), noiseSeed + 1);
+}
+
+void SIGAudioProcessor::seekNoise(std::int64_t samplePosition)
+{
+    pink.seek(samplePosition);
+    whiteNoise.seek(samplePosition);
+}
+
+juce::Array<Multisine::Tone> SIGAudioProcessor::getMultisineTones() const
+{
+    const juce::ScopedLock sl(multisineLock);
+    return multisineTones;
+}
+
+//Walk routing helpers
+//The walk steps through the channels switched on in the mask that the output actually has (all of them if none are on)
+std::uint64_t SIGAudioProcessor::getEnabledChannels(int numChannels) const
+{
+    auto available = numChannels >= maxChannels ? ~std::uint64_t (0) : (std::uint64_t (1) << numChannels) - 1;
+    auto enabled = playing.channelMask & available;
+    
+    return enabled != 0 ? enabled : available;
+}
+
+int SIGAudioProcessor::getNextWalkChannel(int numChannels) const
+{
+    auto enabled = getEnabledChannels(numChannels);
+    
+    for(int step = 1; step <= numChannels; ++step)
+    {
+        auto channel = (walkChannel + step) % numChannels;
+        
+        if((enabled >> channel) & 1)
+            return channel;
     }
+    
+    return 0;
 }
 
-//Function for pink noise processing
-void SIGAudioProcessor::pinkNoiseProcess(juce::AudioBuffer<float> &buffer)
+int SIGAudioProcessor::getWalkPeriod() const
 {
-    auto block = juce::dsp::AudioBlock<float> (buffer);
+    return juce::jmax(1, juce::roundToInt(playing.walkSeconds * getSampleRate()));
+}
+
+//Function for gain processing
+//The smoothed ramp is worked out once per chunk into gainRamp and shared by every channel that gainProcess is called on.
+//When the smoother is idle there's no ramp and gainProcess is a single constant multiply
+void SIGAudioProcessor::gainRampProcess(int numSamples)
+{
+    gainIsRamping = gain.isSmoothing();
     
-    for(int channel = 0; channel < block.getNumChannels(); ++channel)
+    if(gainIsRamping)
     {
-        auto* channelData = block.getChannelPointer(channel);
+        for(int sample = 0; sample < numSamples; ++sample)
+        {
+            gainRamp[sample] = gain.getNextValue();
+        }
+    }
+}
 
-        for(int sample = 0; sample < block.getNumSamples(); ++sample)
+template <typename SampleType>
+void SIGAudioProcessor::gainProcess(SampleType* dest, int numSamples)
+{
+    if constexpr (std::is_same<SampleType, float>::value)
+    {
+        if(gainIsRamping)
+            juce::FloatVectorOperations::multiply(dest, gainRamp, numSamples);
+        else
+            juce::FloatVectorOperations::multiply(dest, gain.getCurrentValue(), numSamples);
+    }
+    else
+    {
+        //the ramp is float, there's no mixed type FloatVectorOperations so it's a plain loop
+        if(gainIsRamping)
+        {
+            for(int sample = 0; sample < numSamples; ++sample)
+                dest[sample] *= (SampleType) gainRamp[sample];
+        }
+        else
         {
-            channelData[sample] = pn.GetNextValue();
-            channelData[sample] *= gain.getNextValue() * 0.00849; //dropping pink noise output...check pink noise class for reason it is outputting such a high value
+            juce::FloatVectorOperations::multiply(dest, (SampleType) gain.getCurrentValue(), numSamples);
         }
     }
 }
 
+//Runs a float only generator (the noise and the multisine) into dest. Double blocks go through the float scratch
+//and get widened, there's nothing for the extra precision to do on noise
+template <typename SampleType, typename Generator>
+void SIGAudioProcessor::renderFloatGenerator(SampleType* dest, int numSamples, Generator&& generate)
+{
+    if constexpr (std::is_same<SampleType, float>::value)
+    {
+        generate(dest, numSamples);
+    }
+    else
+    {
+        auto* scratch = signalBuffer.getWritePointer(0);
+        generate(scratch, numSamples);
+        
+        for(int sample = 0; sample < numSamples; ++sample)
+            dest[sample] = (SampleType) scratch[sample];
+    }
+}
+
+template <typename SampleType>
+SampleType* SIGAudioProcessor::getSignalScratch()
+{
+    if constexpr (std::is_same<SampleType, float>::value)
+        return signalBuffer.getWritePointer(0);
+    else
+        return doubleSignalBuffer.getWritePointer(0);
+}
+
 //==============================================================================
 bool SIGAudioProcessor::hasEditor() const
 {
@@ -453,24 +1358,115 @@ juce::AudioProcessorEditor* SIGAudioProcessor::createEditor()
 }
 
 //==============================================================================
+//Binary state:
+//    'SIGS'  int32 magic
+//    int16   version
+//    cint    current program
+//    string  multisine tones
+//    the current parameter values as a one preset bank, then the program bank (see PresetBank.h)
+//Sessions saved before this stored the parameter ValueTree and still load
+static constexpr juce::int32 stateMagic = 0x53494753; // 'SIGS'
+static constexpr int stateVersion = 2;  //2 added the sequence
+
 void SIGAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
     // Save params
     juce::MemoryOutputStream stream(destData, false);
-    treeState.state.writeToStream(stream);
+    stream.writeInt(stateMagic);
+    stream.writeShort((short) stateVersion);
+    stream.writeCompressedInt(currentProgram.load());
+    stream.writeString(Multisine::tonesToString(getMultisineTones()));
+    captureCurrentSettings("Current").writeToStream(stream);
+    presetBank.writeToStream(stream);
+    stream.writeString(testSequence.toString());
 }
 
 void SIGAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // Recall params
+    juce::MemoryInputStream stream(data, (size_t) sizeInBytes, false);
+    
+    if(sizeInBytes >= 6 && stream.readInt() == stateMagic)
+    {
+        auto version = (int) stream.readShort();
+        
+        if(version > stateVersion)
+            return;
+        
+        auto program = stream.readCompressedInt();
+        auto tones = Multisine::parseTones(stream.readString());
+        PresetBank current, bank;
+        
+        if(PresetBank::readFromStream(stream, current).failed() || current.size() == 0)
+            return;
+        
+        if(PresetBank::readFromStream(stream, bank).wasOk())
+            setPresetBank(bank);
+        
+        currentProgram = juce::jlimit(0, juce::jmax(0, (int) programs.size() - 1), program);
+        applyPresetValues(current, 0);
+        
+        if(! tones.isEmpty())
+            setMultisineTones(tones);
+        
+        TestSequence sequence;
+        
+        if(version >= 2 && TestSequence::parse(stream.readString(), sequence).wasOk())
+            setTestSequence(sequence);
+        
+        return;
+    }
+    
     auto tree = juce::ValueTree::readFromData(data, size_t(sizeInBytes));
         
     if(tree.isValid())
     {
+        upgradeLegacyState(tree);
         treeState.replaceState(tree);
+        
+        auto tones = Multisine::parseTones(treeState.state.getProperty("multisineTones").toString());
+        
+        if(! tones.isEmpty())
+            setMultisineTones(tones);
     }
 }
 
+//Sessions saved before version 1.2 stored signal type and routing as three bools each (sine/white/pink and l/lr/r),
+//this swaps them for the "signal" and "routing" choice parameters
+void SIGAudioProcessor::upgradeLegacyState(juce::ValueTree& tree)
+{
+    auto findParam = [&tree](const juce::String& paramID)
+    {
+        return tree.getChildWithProperty("id", paramID);
+    };
+    
+    auto upgradeChoice = [&](const juce::String& choiceID, const juce::StringArray& legacyIDs)
+    {
+        if(findParam(choiceID).isValid())
+            return;
+        
+        for(int index = 0; index < legacyIDs.size(); ++index)
+        {
+            auto legacyParam = findParam(legacyIDs[index]);
+            
+            if(legacyParam.isValid() && (float) legacyParam.getProperty("value") >= 0.5f)
+            {
+                juce::ValueTree choice("PARAM");
+                choice.setProperty("id", choiceID, nullptr);
+                choice.setProperty("value", index, nullptr);
+                tree.appendChild(choice, nullptr);
+                break;
+            }
+        }
+        
+        for(auto& legacyID : legacyIDs)
+            tree.removeChild(findParam(legacyID), nullptr);
+    };
+    
+    upgradeChoice("signal", { "sine", "white", "pink" });
+    upgradeChoice("routing", { "l", "lr", "r" });
+}
+
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -10,11 +10,22 @@
 
 #include <JuceHeader.h>
 #include "PinkNoise.h"
+#include "CachedSineOscillator.h"
+#include "SineSweep.h"
+#include "Multisine.h"
+#include "WhiteNoise.h"
+#include "BandLimitedOscillator.h"
+#include "OutputMeter.h"
+#include "PresetBank.h"
+#include "SharedGenerators.h"
+#include "BlockTimer.h"
+#include "TestSequence.h"
 
 //==============================================================================
 /**
 */
-class SIGAudioProcessor  : public juce::AudioProcessor, juce::AudioProcessorValueTreeState::Listener
+class SIGAudioProcessor  : public juce::AudioProcessor,
+                           private juce::Timer
 {
 public:
     //==============================================================================
@@ -30,6 +41,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -55,36 +68,268 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     juce::AudioProcessorValueTreeState treeState;
+    
+    //deconvolution filter for the sweep the current parameters make, at the current sample rate.
+    //Allocates, call it from the message thread or an offline renderer
+    juce::AudioBuffer<float> createSweepInverseFilter() const;
+    
+    //noise streams. Every instance gets a random seed, setting one makes the noise repeatable. Both are for
+    //when nothing is processing, set the seed before prepareToPlay and seek after it. seekNoise moves the white
+    //and pink noise to any sample, so a long render can be split into pieces that match a render in one go
+    void setNoiseSeed(std::uint64_t seed);
+    void seekNoise(std::int64_t samplePosition);
+    
+    //tones of the Multisine signal, saved with the plugin state. Setting them rebuilds the loop table in the background
+    void setMultisineTones(const juce::Array<Multisine::Tone>& tones);
+    juce::Array<Multisine::Tone> getMultisineTones() const;
+    
+    //program bank. Setting or loading a bank allocates and is for the message thread, setCurrentProgram is
+    //safe from any thread and the audio thread switches to the program at the top of its next block
+    void setPresetBank(const PresetBank& newBank);
+    const PresetBank& getPresetBank() const noexcept { return presetBank; }
+    juce::Result loadPresetBank(const juce::File& file);
+    juce::Result savePresetBank(const juce::File& file) const;
+    PresetBank createFactoryBank() const;
+    //the current parameter values as a one preset bank, in the order the bank format uses
+    PresetBank captureCurrentSettings(const juce::String& name) const;
+    
+    //steps the sequencer plays while the Sequencer parameter is on, saved with the plugin state. Setting or loading
+    //allocates and is for the message thread, the sequencer starts again from the first step of the new list
+    void setTestSequence(const TestSequence& newSequence);
+    const TestSequence& getTestSequence() const noexcept { return testSequence; }
+    juce::Result loadTestSequence(const juce::File& file);
+    
+    //level and spectrum feed for the editor, it only measures while the editor is open
+    OutputMeter& getOutputMeter() noexcept { return outputMeter; }
+    
+   #if SIG_BLOCK_TIMING
+    //processBlock time against its deadline, for the editor. writeBlockTiming appends the counts to a file
+    //(SIG_BLOCK_TIMING_FILE in the environment does the same at every releaseResources)
+    BlockTimer& getBlockTimer() noexcept { return blockTimer; }
+    juce::Result writeBlockTiming(const juce::File& file) const { return blockTimer.appendToFile(file); }
+   #endif
+    
+    //most output channels SIG will render to, one bit of the routing mask each
+    static constexpr int maxChannels = 64;
+    
 private:
     
-    //juce oscillator instantiation
-    juce::dsp::Oscillator<float> osc { [](float x) { return std::sin (x); }, 200 }; //200 is lookup table value - not sure what that is but it makes it more efficient??
-    //White noise random instantiation
-    juce::Random random;
+    //background thread that builds the loop tables for the cached sine and the multisine
+    juce::TimeSliceThread tableBuilderThread { "SIG table builder" };
+    
+    //sine oscillator instantiation (block based, double precision phase, plays a loop once the frequency is steady)
+    CachedSineOscillator osc;
+    CachedSineBuilder oscBuilder { osc, tableBuilderThread };
+    //White noise instantiation, one stream per output channel
+    WhiteNoiseBank whiteNoise;
     //Pink noise object instantiation
-    PinkNumber pn;
-
-    // return std::sin (x);  // sine wave
-    // return x / juce::MathConstants<float>::pi;  // saw wave
-    // return x < 0.0f ? -1.0f : 1.0f;   // square wave
+    PinkNoise pink;
+    //log/linear sweep for impulse response capture
+    SineSweep sweep;
+    //multitone loop table and the thread that builds it
+    Multisine multisine;
+    MultisineBuilder multisineBuilder { multisine, tableBuilderThread };
+    juce::Array<Multisine::Tone> multisineTones;
+    juce::CriticalSection multisineLock;
+    //saw, square/pulse and triangle, PolyBLEP so they don't alias
+    BandLimitedOscillator shapeOsc;
+    //process-wide generator this instance reads from when the Shared Engine parameter is on
+    SharedSignal sharedSignal;
+    //what processBlock sends out, for the editor's meters
+    OutputMeter outputMeter;
+   #if SIG_BLOCK_TIMING
+    BlockTimer blockTimer;
+    const juce::String blockTimingFile { juce::SystemStats::getEnvironmentVariable("SIG_BLOCK_TIMING_FILE", {}) };
+   #endif
+    
+    enum SignalType { sineSignal, whiteSignal, pinkSignal, sweepSignal, multisineSignal, sawSignal, squareSignal, triangleSignal, numSignalTypes };
+    enum Routing { routeL, routeLR, routeR, routeCustom, routeWalk, numRoutings };
+    
+    //Everything the dsp needs from the parameters, read once at the top of each block
+    struct Settings
+    {
+        float gainDecibels { -20.0f };
+        float frequency { 440.0f };
+        bool bypass { false };
+        bool gaussian { false };
+        bool sineCache { true };
+        int signalType { 0 };
+        int routingChoice { 1 };
+        std::uint64_t channelMask { ~std::uint64_t (0) };
+        float walkSeconds { 1.0f };
+        float pulseWidth { 0.5f };
+        bool midiControl { false };
+        bool shared { false };
+        bool sequencer { false };
+        SineSweep::Parameters sweep;
+    };
+    static_assert (std::is_trivially_copyable<Settings>::value, "Settings is copied on the audio thread");
+    
+    Settings readSettings() const;
+    template <typename ValueSource>
+    Settings makeSettings(ValueSource&& valueOf) const;
+    
+    //cached parameter atomics, set in the constructor
+    std::atomic<float>* gainParam { nullptr };
+    std::atomic<float>* freqParam { nullptr };
+    std::atomic<float>* bypassParam { nullptr };
+    std::atomic<float>* signalParam { nullptr };
+    std::atomic<float>* routingParam { nullptr };
+    std::atomic<float>* gaussianParam { nullptr };
+    std::atomic<float>* sineCacheParam { nullptr };
+    std::atomic<float>* walkTimeParam { nullptr };
+    std::atomic<float>* midiParam { nullptr };
+    std::atomic<float>* pulseWidthParam { nullptr };
+    std::atomic<float>* sharedParam { nullptr };
+    std::atomic<float>* sequencerParam { nullptr };
+    std::atomic<float>* sweepModeParam { nullptr };
+    std::atomic<float>* sweepStartParam { nullptr };
+    std::atomic<float>* sweepEndParam { nullptr };
+    std::atomic<float>* sweepTimeParam { nullptr };
+    std::atomic<float>* sweepFadeInParam { nullptr };
+    std::atomic<float>* sweepFadeOutParam { nullptr };
+    std::atomic<float>* sweepRepeatParam { nullptr };
+    std::atomic<float>* sweepGapParam { nullptr };
+    std::array<std::atomic<float>*, maxChannels> channelParams {};
+    
+    //a change that lands partway through a block, processBlock splits the block at sampleOffset
+    struct Event
+    {
+        enum class Type { frequency, gain, signal, step };
+        
+        int sampleOffset;
+        Type type;
+        float value;
+    };
+    
+    //reserved in the constructor, the audio thread drops events past this rather than allocating
+    static constexpr int maxEventsPerBlock = 256;
     
     // variable instantiations
+    Settings settings;
+    //what the output renders with, settings as they were last applied except that a signal, routing or on/off
+    //change waits there for a running crossfade to finish
+    Settings playing;
+    //the parameters as they were last block, only parameters that have moved since override a MIDI change
+    Settings parameterSettings;
+    std::vector<Event> events;
     juce::LinearSmoothedValue<float> gain { 0.0f };
-    juce::dsp::Panner<float> panner;
-    float freq { 440.0f };
-    bool bypass { false };
-    int routingChoice { 1 };
-    int signalType { 0 };
+    juce::HeapBlock<float> gainRamp;
+    bool gainIsRamping { false };
+    juce::AudioBuffer<float> signalBuffer;
+    //double precision mono scratch, the sine and the sweep render straight into it
+    juce::AudioBuffer<double> doubleSignalBuffer;
+    std::uint64_t noiseSeed { 0 };
+    
+    //channels the custom and walk kernels write to, bit n is channel n
+    std::uint64_t routingMask { ~std::uint64_t (0) };
+    int walkChannel { 0 };
+    int walkSamplesLeft { 0 };
+    
+    //Crossfade on a signal, routing or on/off change. The old output goes in fadeBuffer, the curves and buffers
+    //are made in prepareToPlay so a fade doesn't allocate, and with no fade running it's one test per segment.
+    //Fades don't overlap, a change during one starts its own fade when it ends
+    struct FadeSource
+    {
+        bool on { false };
+        int signalType { 0 };
+        int routingChoice { 0 };
+        std::uint64_t routedChannels { 0 };
+    };
+    
+    static constexpr double fadeSeconds = 0.02;
+    FadeSource fadeFrom;
+    BandLimitedOscillator fadeShapeOsc;         //the shape oscillator as it was, saw to square is one object
+    juce::AudioBuffer<float> fadeBuffer;
+    juce::AudioBuffer<double> doubleFadeBuffer;
+    juce::HeapBlock<float> fadeInCurve, fadeOutCurve;
+    int fadeLength { 0 };
+    int fadePosition { 0 };
+    int fadeSamplesLeft { 0 };
+    bool renderingFadeOut { false };            //keeps the old signal off the shared engine
+    
+    //Sequencer. Its position is counted in samples from the first step and step changes land on the sample
+    //where the step's start time rounds to, so a list plays out the same whatever the block sizes and however
+    //fast the host runs (a step under 20ms after a signal change waits for that crossfade, but the next step's
+    //time doesn't move). testSequence is only swapped under the callback lock
+    TestSequence testSequence;
+    bool sequencerRunning { false };
+    int sequenceStep { -1 };
+    std::int64_t sequencePosition { 0 };
+    std::int64_t nextStepPosition { 0 };
+    double nextStepSeconds { 0.0 };
     
     //Functions for dsp
-    float panRoutingFunc(int choice);
-    void oscProcess(juce::AudioBuffer<float> &buffer);
-    void whiteNoiseProcess(juce::AudioBuffer<float> &buffer);
-    void pinkNoiseProcess(juce::AudioBuffer<float> &buffer);
+    void gainRampProcess(int numSamples);
+    template <typename SampleType>
+    void gainProcess(SampleType* dest, int numSamples);
+    template <typename SampleType, typename Generator>
+    void renderFloatGenerator(SampleType* dest, int numSamples, Generator&& generate);
+    template <typename SampleType>
+    SampleType* getSignalScratch();
+    std::uint64_t getEnabledChannels(int numChannels) const;
+    int getNextWalkChannel(int numChannels) const;
+    int getWalkPeriod() const;
+    static void mergeParameterChanges(Settings& target, const Settings& before, const Settings& after);
+    void collectMidiEvents(const juce::MidiBuffer& midiMessages, int numSamples);
+    void collectSequenceEvents(int numSamples);
+    void applyStep(int stepIndex);
+    void applyEvent(const Event& event);
+    void applySettings();
+    bool isSwitchWaiting() const noexcept;
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+    template <typename SampleType>
+    void renderSegment(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples);
+    template <typename SampleType>
+    void renderSettings(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples);
+    template <typename SampleType>
+    void renderCrossfade(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples);
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType>& getFadeScratch();
+    std::uint64_t getRoutedChannels(int routingChoice, std::uint64_t channelMask) const;
+    
+    //Render kernels, one per sample type x signal type x routing x channel count (1, 2 or any). Custom and walk share the routingMask kernel
+    template <typename SampleType>
+    using RenderKernel = void (SIGAudioProcessor::*)(juce::AudioBuffer<SampleType>&, int, int);
+    template <typename SampleType>
+    using ChannelKernels = std::array<RenderKernel<SampleType>, 3>;
+    
+    template <typename SampleType, int Signal, int Route, int NumChannels>
+    void renderKernel(juce::AudioBuffer<SampleType> &buffer, int startSample, int numSamples);
+    template <typename SampleType, int Signal, int Route>
+    static ChannelKernels<SampleType> makeChannelKernels();
+    template <typename SampleType>
+    static RenderKernel<SampleType> getRenderKernel(int signalType, int routingChoice, int numChannels);
+    
+    //Programs
+    //presetBank is what's saved, programs is it compiled against this version's parameters so a program change
+    //on the audio thread is one Settings copy, and the parameter values the message thread then shows the host
+    struct Program
+    {
+        juce::String name;
+        Settings settings;
+        std::vector<float> normalisedValues; // one per presetParameters entry
+    };
+    
+    PresetBank presetBank;
+    std::vector<Program> programs;
+    //every parameter but the momentary shortcut buttons, in bank order, and their atomics
+    juce::Array<juce::RangedAudioParameter*> presetParameters;
+    juce::Array<std::atomic<float>*> presetParameterValues;
+    std::atomic<int> numPrograms { 0 };         //programs.size() for setCurrentProgram, which doesn't lock
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<int> pendingProgram { -1 };     //audio thread picks it up
+    std::atomic<int> programToPublish { -1 };   //message thread sends the values to the host
+    
+    std::vector<Program> compilePrograms(const PresetBank& bank) const;
+    void publishProgram(int index);
+    void applyPresetValues(const PresetBank& bank, int presetIndex);
+    void timerCallback() override;
     
-    //Functions for param layout and changes
+    //Functions for param layout and state
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    static void upgradeLegacyState(juce::ValueTree& tree);
     
     
     //==============================================================================
@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// A bank of programs in a small versioned binary format:
+//     'SIGB'  int32 magic
+//     int16   format version
+//     cint    number of parameters, then each parameter ID as a string
+//     cint    number of presets, then for each: name as a string and one float32 per parameter
+// (cint is juce's compressed int, strings are null terminated UTF-8).
+// Values are the plain parameter values (Hz, dB, choice index) in the order of the ID list, so a bank
+// still loads after parameters are added, removed or have their ranges changed. IDs the plugin doesn't
+// know are skipped and parameters the bank doesn't have keep their defaults
+
+struct PresetBank
+{
+    struct Preset
+    {
+        juce::String name;
+        std::vector<float> values;  // one per parameterIDs entry
+    };
+
+    static constexpr juce::int32 magic = 0x53494742; // 'SIGB'
+    static constexpr int currentVersion = 1;
+
+    juce::StringArray parameterIDs;
+    std::vector<Preset> presets;
+
+    int size() const noexcept { return (int) presets.size(); }
+
+    // the preset's value for a parameter, or fallback if the bank doesn't have that parameter
+    float getValue (int presetIndex, const juce::String& parameterID, float fallback) const
+    {
+        auto index = parameterIDs.indexOf (parameterID);
+        auto& values = presets[(size_t) presetIndex].values;
+
+        return juce::isPositiveAndBelow (index, (int) values.size()) ? values[(size_t) index] : fallback;
+    }
+
+    void writeToStream (juce::OutputStream& stream) const
+    {
+        stream.writeInt (magic);
+        stream.writeShort ((short) currentVersion);
+
+        stream.writeCompressedInt (parameterIDs.size());
+
+        for (auto& id : parameterIDs)
+            stream.writeString (id);
+
+        stream.writeCompressedInt (size());
+
+        for (auto& preset : presets)
+        {
+            stream.writeString (preset.name);
+
+            for (int i = 0; i < parameterIDs.size(); ++i)
+                stream.writeFloat (i < (int) preset.values.size() ? preset.values[(size_t) i] : 0.0f);
+        }
+    }
+
+    static juce::Result readFromStream (juce::InputStream& stream, PresetBank& bank)
+    {
+        if (stream.readInt() != magic)
+            return juce::Result::fail ("not a SIG preset bank");
+
+        auto version = (int) stream.readShort();
+
+        if (version < 1)
+            return juce::Result::fail ("corrupt preset bank");
+
+        if (version > currentVersion)
+            return juce::Result::fail ("preset bank version " + juce::String (version) + " is newer than this SIG");
+
+        PresetBank newBank;
+        auto numParameters = stream.readCompressedInt();
+
+        if (numParameters < 0 || numParameters > 4096)
+            return juce::Result::fail ("corrupt preset bank");
+
+        for (int i = 0; i < numParameters; ++i)
+            newBank.parameterIDs.add (stream.readString());
+
+        auto numPresets = stream.readCompressedInt();
+
+        if (numPresets < 0 || numPresets > 65536)
+            return juce::Result::fail ("corrupt preset bank");
+
+        for (int p = 0; p < numPresets; ++p)
+        {
+            Preset preset;
+            preset.name = stream.readString();
+            preset.values.resize ((size_t) numParameters);
+
+            for (auto& value : preset.values)
+                value = stream.readFloat();
+
+            if (stream.isExhausted() && p < numPresets - 1)
+                return juce::Result::fail ("preset bank is cut short");
+
+            newBank.presets.push_back (std::move (preset));
+        }
+
+        bank = std::move (newBank);
+        return juce::Result::ok();
+    }
+
+    juce::Result saveToFile (const juce::File& file) const
+    {
+        juce::MemoryOutputStream stream;
+        writeToStream (stream);
+
+        return file.replaceWithData (stream.getData(), stream.getDataSize())
+                 ? juce::Result::ok()
+                 : juce::Result::fail ("couldn't write " + file.getFullPathName());
+    }
+
+    static juce::Result loadFromFile (const juce::File& file, PresetBank& bank)
+    {
+        juce::FileInputStream stream (file);
+
+        if (! stream.openedOk())
+            return juce::Result::fail ("couldn't open " + file.getFullPathName());
+
+        return readFromStream (stream, bank);
+    }
+};
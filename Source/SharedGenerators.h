@@ -0,0 +1,267 @@
+/*
+  ==============================================================================
+
+    SharedGenerators.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SineOscillator.h"
+#include "PinkNoise.h"
+#include "BandLimitedOscillator.h"
+
+// One set of generators for the whole process, for sessions with lots of SIG instances playing the same thing.
+// Instances with the same signal, frequency, pulse width and sample rate subscribe to the same Generator, which
+// renders into a ring buffer. Whichever subscriber gets to a block first renders it and the rest copy it out,
+// so the CPU goes with the number of different signals rather than the number of instances.
+// Reading never locks, a copy is checked against numRendered after it's made in case a render went round the ring
+// underneath it. Rendering the next block takes a spin lock per generator, so an instance that arrives while
+// another is rendering that same block waits for that one render instead of doing its own.
+// Every generator and ring is allocated up front with the pool (by the first instance, on the message thread),
+// subscribing claims a free slot under a spin lock and never allocates, so it's fine on the audio thread.
+// Only the sine, pink noise and band limited shapes are shared. White noise stays decorrelated per channel,
+// the sweep restarts per instance and the multisine tones are per instance
+
+class SharedGeneratorPool
+{
+public:
+
+    struct Key
+    {
+        int signal { -1 };  // SIGAudioProcessor::SignalType
+        float frequency { 0.0f };
+        float pulseWidth { 0.0f };
+        double sampleRate { 0.0 };
+
+        bool operator== (const Key& other) const noexcept
+        {
+            return signal == other.signal && frequency == other.frequency
+                && pulseWidth == other.pulseWidth && sampleRate == other.sampleRate;
+        }
+
+        bool operator!= (const Key& other) const noexcept { return ! operator== (other); }
+    };
+
+    enum class Shape
+    {
+        sine,
+        pink,
+        saw,
+        square,
+        triangle
+    };
+
+    static constexpr int maxGenerators = 32;
+    static constexpr int ringSize = 1 << 14;
+    static constexpr int maxRead = ringSize / 4; // reads go in pieces of this so a render can't lap a reader
+
+    class Generator
+    {
+    public:
+
+        Generator() : ring ((size_t) ringSize) {}
+
+        std::int64_t getNumRendered() const noexcept { return numRendered.load (std::memory_order_acquire); }
+
+        // copies numSamples from position on and moves position along, rendering whatever isn't there yet.
+        // A reader that has fallen more than a ring behind (its host stopped calling it) skips to the newest,
+        // and so does one whose copy was written over while it was being made
+        void read (std::int64_t& position, float* dest, int numSamples) noexcept
+        {
+            for (int done = 0; done < numSamples;)
+            {
+                auto num = juce::jmin (maxRead, numSamples - done);
+
+                if (position + ringSize - maxRead < getNumRendered())
+                    position = getNumRendered();
+
+                if (position + num > getNumRendered())
+                    renderUpTo (position + num);
+
+                for (int i = 0; i < num;)
+                {
+                    auto index = (int) ((position + i) % ringSize);
+                    auto piece = juce::jmin (num - i, ringSize - index);
+
+                    std::copy (ring.begin() + index, ring.begin() + index + piece, dest + done + i);
+                    i += piece;
+                }
+
+                // A render only ever goes up to maxRead past numRendered, so if that's still short of a ring past
+                // position nothing copied was touched. Otherwise this thread was held up mid copy, start again
+                std::atomic_thread_fence (std::memory_order_acquire);
+
+                if (getNumRendered() + maxRead > position + ringSize)
+                {
+                    position = getNumRendered();
+                    continue;
+                }
+
+                position += num;
+                done += num;
+            }
+        }
+
+    private:
+
+        friend class SharedGeneratorPool;
+
+        void prepare (Shape newShape, const Key& newKey)
+        {
+            shape = newShape;
+            key = newKey;
+
+            sine.prepare (key.sampleRate);
+            sine.setFrequency (key.frequency);
+            pink.reset();
+            bandLimited.prepare (key.sampleRate);
+            bandLimited.setFrequency (key.frequency);
+            bandLimited.setPulseWidth (key.pulseWidth);
+
+            if (shape == Shape::saw)      bandLimited.setWaveform (BandLimitedOscillator::Waveform::saw);
+            if (shape == Shape::square)   bandLimited.setWaveform (BandLimitedOscillator::Waveform::square);
+            if (shape == Shape::triangle) bandLimited.setWaveform (BandLimitedOscillator::Waveform::triangle);
+
+            numRendered.store (0, std::memory_order_release);
+        }
+
+        void renderUpTo (std::int64_t end) noexcept
+        {
+            const juce::SpinLock::ScopedLockType sl (renderLock);
+            auto rendered = numRendered.load (std::memory_order_relaxed);
+
+            // someone else may have rendered it while this waited for the lock
+            while (rendered < end)
+            {
+                auto index = (int) (rendered % ringSize);
+                auto num = (int) juce::jmin ((std::int64_t) (ringSize - index), end - rendered);
+                auto* dest = ring.data() + index;
+
+                switch (shape)
+                {
+                    case Shape::sine: sine.process (dest, num); break;
+                    case Shape::pink: pink.process (dest, num); break;
+                    default:          bandLimited.process (dest, num); break;
+                }
+
+                rendered += num;
+            }
+
+            numRendered.store (rendered, std::memory_order_release);
+        }
+
+        std::vector<float> ring;
+        std::atomic<std::int64_t> numRendered { 0 };
+        juce::SpinLock renderLock;
+
+        int numSubscribers { 0 }; // only touched under the pool's lock
+        Key key;
+        Shape shape { Shape::sine };
+
+        SineOscillator sine;
+        PinkNoise pink;
+        BandLimitedOscillator bandLimited;
+
+        JUCE_DECLARE_NON_COPYABLE (Generator)
+    };
+
+    // the generator for key, started fresh if nobody else is playing it. nullptr when every slot is taken,
+    // the instance then renders with its own generators
+    Generator* subscribe (Shape shape, const Key& key) noexcept
+    {
+        const juce::SpinLock::ScopedLockType sl (poolLock);
+        Generator* freeSlot = nullptr;
+
+        for (auto& generator : generators)
+        {
+            if (generator.numSubscribers > 0 && generator.key == key)
+            {
+                ++generator.numSubscribers;
+                return &generator;
+            }
+
+            if (generator.numSubscribers == 0 && freeSlot == nullptr)
+                freeSlot = &generator;
+        }
+
+        if (freeSlot != nullptr)
+        {
+            freeSlot->prepare (shape, key);
+            freeSlot->numSubscribers = 1;
+        }
+
+        return freeSlot;
+    }
+
+    void unsubscribe (Generator* generator) noexcept
+    {
+        const juce::SpinLock::ScopedLockType sl (poolLock);
+
+        if (generator != nullptr)
+            --generator->numSubscribers;
+    }
+
+    int getNumActiveGenerators() const noexcept
+    {
+        const juce::SpinLock::ScopedLockType sl (poolLock);
+        return (int) std::count_if (generators.begin(), generators.end(), [] (auto& g) { return g.numSubscribers > 0; });
+    }
+
+private:
+
+    std::array<Generator, maxGenerators> generators;
+    mutable juce::SpinLock poolLock;
+};
+
+// One instance's subscription. Holding one keeps the pool alive (juce::SharedResourcePointer), so the pool
+// goes away with the last instance
+class SharedSignal
+{
+public:
+
+    ~SharedSignal()
+    {
+        unsubscribe();
+    }
+
+    // moves to the generator for key, nothing happens if it's already on it. The new generator's stream is
+    // picked up where it is, so changing a shared signal's settings isn't phase continuous
+    void subscribe (SharedGeneratorPool::Shape shape, const SharedGeneratorPool::Key& newKey) noexcept
+    {
+        if (generator != nullptr && newKey == key)
+            return;
+
+        unsubscribe();
+
+        key = newKey;
+        generator = pool->subscribe (shape, key);
+
+        if (generator != nullptr)
+            position = generator->getNumRendered();
+    }
+
+    void unsubscribe() noexcept
+    {
+        pool->unsubscribe (generator);
+        generator = nullptr;
+    }
+
+    bool isSubscribed() const noexcept { return generator != nullptr; }
+
+    void read (float* dest, int numSamples) noexcept
+    {
+        jassert (isSubscribed());
+        generator->read (position, dest, numSamples);
+    }
+
+    SharedGeneratorPool& getPool() noexcept { return *pool; }
+
+private:
+
+    juce::SharedResourcePointer<SharedGeneratorPool> pool;
+    SharedGeneratorPool::Generator* generator { nullptr };
+    SharedGeneratorPool::Key key;
+    std::int64_t position { 0 };
+};
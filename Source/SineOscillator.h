@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    SineOscillator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <cmath>
+#include "FastMath.h"
+
+// Block based sine generator. The phase is kept in cycles as a double so long
+// running tones don't drift, and each block is filled by a branch-free loop
+// (phase -> polynomial) that the compiler vectorises for SSE/AVX/NEON.
+// process works on float or double blocks, double uses the double precision polynomial.
+
+class SineOscillator
+{
+public:
+
+    void prepare (double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        setFrequency (frequency);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        phase = 0.0;
+    }
+
+    void setFrequency (double newFrequency) noexcept
+    {
+        frequency = newFrequency;
+        increment = frequency / sampleRate;
+    }
+
+    double getFrequency() const noexcept { return frequency; }
+
+    //phase in cycles, 0 to 1
+    double getPhase() const noexcept { return phase; }
+    void setPhase (double newPhase) noexcept { phase = newPhase - std::floor (newPhase); }
+
+    template <typename SampleType>
+    void process (SampleType* dest, int numSamples) noexcept
+    {
+        const auto startPhase = phase;
+        const auto inc = increment;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // wrap to -0.5 to 0.5 cycles in double, only the wrapped value is narrowed to float for float blocks.
+            // p is never negative here so truncating through int is a floor that still vectorises
+            auto p = startPhase + inc * (double) i;
+            p -= (double) (int) (p + 0.5);
+            dest[i] = FastMath::sinCycles ((SampleType) p);
+        }
+
+        phase = startPhase + inc * (double) numSamples;
+        phase -= std::floor (phase);
+    }
+
+private:
+
+    double sampleRate { 44100.0 };
+    double frequency { 440.0 };
+    double increment { 440.0 / 44100.0 };
+    double phase { 0.0 };
+};
@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    SineSweep.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <cmath>
+#include "FastMath.h"
+
+// Logarithmic (Farina exponential sine sweep) and linear sweeps for impulse response capture.
+// The phase of every sample is worked out from its sample index in double, not accumulated, so
+// an hour long sweep lands on the same phase as a one second one:
+//     log:     phase (t) = f1 * L * (exp (t / L) - 1),  L = T / ln (f2 / f1)
+//     linear:  phase (t) = f1 * t + (f2 - f1) * t^2 / 2T
+// createInverseFilter gives the matching deconvolution filter, convolve a recording of the sweep
+// with it to get the impulse response. process fills float or double blocks
+
+class SineSweep
+{
+public:
+
+    enum class Mode
+    {
+        logarithmic,
+        linear
+    };
+
+    struct Parameters
+    {
+        Mode mode { Mode::logarithmic };
+        double startFrequency { 20.0 };
+        double endFrequency { 20000.0 };
+        double seconds { 10.0 };
+        double fadeInSeconds { 0.05 };
+        double fadeOutSeconds { 0.01 };
+        bool repeat { false };
+        double gapSeconds { 1.0 };      // silence after each sweep before it repeats
+
+        bool operator== (const Parameters& other) const noexcept
+        {
+            return mode == other.mode && startFrequency == other.startFrequency && endFrequency == other.endFrequency
+                && seconds == other.seconds && fadeInSeconds == other.fadeInSeconds && fadeOutSeconds == other.fadeOutSeconds
+                && repeat == other.repeat && gapSeconds == other.gapSeconds;
+        }
+
+        bool operator!= (const Parameters& other) const noexcept { return ! operator== (other); }
+    };
+
+    SineSweep()
+    {
+        update();
+    }
+
+    void prepare (double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        update();
+        reset();
+    }
+
+    // back to the start of the sweep
+    void reset() noexcept
+    {
+        position = 0;
+    }
+
+    // a change of any parameter restarts the sweep
+    void setParameters (const Parameters& newParameters) noexcept
+    {
+        if (newParameters != parameters)
+        {
+            parameters = newParameters;
+            update();
+            reset();
+        }
+    }
+
+    const Parameters& getParameters() const noexcept { return parameters; }
+
+    juce::int64 getLengthInSamples() const noexcept { return sweepLength; }
+    juce::int64 getPosition() const noexcept { return position; }
+
+    // true once a sweep that doesn't repeat has played out
+    bool isFinished() const noexcept { return ! parameters.repeat && position >= sweepLength; }
+
+    // instantaneous frequency in Hz at a sample of the sweep
+    double getFrequencyAt (juce::int64 sample) const noexcept
+    {
+        auto t = (double) sample / sampleRate;
+
+        if (isLogarithmic())
+            return parameters.startFrequency * std::exp (t / logRate);
+
+        return parameters.startFrequency + linearRate * t;
+    }
+
+    template <typename SampleType>
+    void process (SampleType* dest, int numSamples) noexcept
+    {
+        while (numSamples > 0)
+        {
+            int numDone;
+
+            if (position < sweepLength)
+            {
+                numDone = (int) juce::jmin ((juce::int64) numSamples, sweepLength - position);
+                renderSweep (dest, position, numDone);
+            }
+            else if (parameters.repeat && position >= sweepLength + gapLength)
+            {
+                position = 0;
+                continue;
+            }
+            else
+            {
+                // the gap, or silence forever when it doesn't repeat
+                numDone = parameters.repeat ? (int) juce::jmin ((juce::int64) numSamples, sweepLength + gapLength - position)
+                                            : numSamples;
+                juce::FloatVectorOperations::clear (dest, numDone);
+            }
+
+            position += numDone;
+            dest += numDone;
+            numSamples -= numDone;
+        }
+    }
+
+    // The time reversed sweep, for a log sweep with a -6dB/oct envelope to undo its pink spectrum.
+    // Scaled so the sweep convolved with it peaks at exactly 1. Allocates, so not on the audio thread
+    juce::AudioBuffer<float> createInverseFilter() const
+    {
+        auto length = (int) sweepLength;
+        juce::AudioBuffer<float> sweep (1, length);
+        juce::AudioBuffer<float> inverse (1, length);
+
+        renderSweep (sweep.getWritePointer (0), 0, length);
+
+        auto* x = sweep.getReadPointer (0);
+        auto* y = inverse.getWritePointer (0);
+
+        for (int i = 0; i < length; ++i)
+        {
+            auto envelope = isLogarithmic() ? std::exp (-((double) i / sampleRate) / logRate) : 1.0;
+            y[i] = (float) (x[length - 1 - i] * envelope);
+        }
+
+        // the convolution at a lag of length - 1 is where the peak lands
+        double peak = 0.0;
+
+        for (int i = 0; i < length; ++i)
+            peak += (double) x[i] * (double) y[length - 1 - i];
+
+        if (peak > 0.0)
+            inverse.applyGain ((float) (1.0 / peak));
+
+        return inverse;
+    }
+
+private:
+
+    bool isLogarithmic() const noexcept
+    {
+        // a log sweep from f to f is a steady tone, that's the linear formula with no slope
+        return parameters.mode == Mode::logarithmic && std::abs (std::log (parameters.endFrequency / parameters.startFrequency)) > 1.0e-9;
+    }
+
+    void update() noexcept
+    {
+        auto& p = parameters;
+
+        sweepLength = juce::jmax ((juce::int64) 1, (juce::int64) std::llround (p.seconds * sampleRate));
+        gapLength = juce::jmax ((juce::int64) 0, (juce::int64) std::llround (p.gapSeconds * sampleRate));
+        fadeInLength = juce::jlimit ((juce::int64) 0, sweepLength, (juce::int64) std::llround (p.fadeInSeconds * sampleRate));
+        fadeOutLength = juce::jlimit ((juce::int64) 0, sweepLength - fadeInLength, (juce::int64) std::llround (p.fadeOutSeconds * sampleRate));
+
+        logRate = p.seconds / std::log (p.endFrequency / p.startFrequency);
+        linearRate = (p.endFrequency - p.startFrequency) / p.seconds;
+    }
+
+    template <typename SampleType>
+    void renderSweep (SampleType* dest, juce::int64 start, int numSamples) const noexcept
+    {
+        const auto f1 = parameters.startFrequency;
+        const auto dt = 1.0 / sampleRate;
+
+        if (isLogarithmic())
+        {
+            const auto scale = f1 * logRate;
+            const auto rate = dt / logRate;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto phase = scale * (std::exp ((double) (start + i) * rate) - 1.0);
+                phase -= std::floor (phase + 0.5);
+                dest[i] = FastMath::sinCycles ((SampleType) phase);
+            }
+        }
+        else
+        {
+            const auto halfRate = 0.5 * linearRate;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto t = (double) (start + i) * dt;
+                auto phase = t * (f1 + halfRate * t);
+                phase -= std::floor (phase + 0.5);
+                dest[i] = FastMath::sinCycles ((SampleType) phase);
+            }
+        }
+
+        applyFades (dest, start, numSamples);
+    }
+
+    // raised cosine fades, only the samples that are in a fade get touched
+    template <typename SampleType>
+    void applyFades (SampleType* dest, juce::int64 start, int numSamples) const noexcept
+    {
+        const auto end = start + numSamples;
+        const auto fadeOutStart = sweepLength - fadeOutLength;
+
+        for (auto n = start; n < juce::jmin (end, fadeInLength); ++n)
+            dest[n - start] *= (SampleType) (0.5 - 0.5 * std::cos (juce::MathConstants<double>::pi * (double) n / (double) fadeInLength));
+
+        for (auto n = juce::jmax (start, fadeOutStart); n < end; ++n)
+            dest[n - start] *= (SampleType) (0.5 - 0.5 * std::cos (juce::MathConstants<double>::pi * (double) (sweepLength - n) / (double) fadeOutLength));
+    }
+
+    Parameters parameters;
+    double sampleRate { 44100.0 };
+    double logRate { 1.0 };
+    double linearRate { 0.0 };
+    juce::int64 sweepLength { 1 };
+    juce::int64 gapLength { 0 };
+    juce::int64 fadeInLength { 0 };
+    juce::int64 fadeOutLength { 0 };
+    juce::int64 position { 0 };
+};
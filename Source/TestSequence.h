@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    TestSequence.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// A list of steps for the sequencer to play through, one step per line:
+//     # signal  freq   gain  routing  seconds
+//     sine      1000   -20   lr       2
+//     pink      -      -12   -        1
+//     off                             0.5
+//     loop
+// signal is one of the Signal choices (sine, white, pink, sweep, multisine, saw, square, triangle) or off for
+// silence, routing one of l, lr, r, custom or walk. A - keeps the value of the step before (the first step starts
+// from 1000Hz, -20dB, lr). loop on a line of its own plays the list again from the top, otherwise SIG goes
+// off after the last step. Steps are 10ms to an hour long, # starts a comment
+
+struct TestSequence
+{
+    struct Step
+    {
+        bool on { true };
+        int signalType { 0 };       // index into the Signal choice
+        float frequency { 1000.0f };
+        float gainDecibels { -20.0f };
+        int routing { 1 };          // index into the Routing choice
+        double seconds { 1.0 };
+    };
+
+    static constexpr double minStepSeconds = 0.01;
+    static constexpr double maxStepSeconds = 3600.0;
+
+    std::vector<Step> steps;
+    bool loop { false };
+
+    bool isEmpty() const noexcept { return steps.empty(); }
+
+    double getLengthInSeconds() const noexcept
+    {
+        double seconds = 0.0;
+
+        for (auto& step : steps)
+            seconds += step.seconds;
+
+        return seconds;
+    }
+
+    juce::String toString() const
+    {
+        juce::StringArray lines;
+
+        for (auto& step : steps)
+        {
+            if (! step.on)
+                lines.add ("off " + juce::String (step.seconds));
+            else
+                lines.add (signalNames()[step.signalType] + " " + juce::String (step.frequency) + " " + juce::String (step.gainDecibels)
+                             + " " + routingNames()[step.routing] + " " + juce::String (step.seconds));
+        }
+
+        if (loop)
+            lines.add ("loop");
+
+        return lines.joinIntoString ("\n");
+    }
+
+    static juce::Result parse (const juce::String& text, TestSequence& sequence)
+    {
+        TestSequence newSequence;
+        Step previous;
+        int lineNumber = 0;
+
+        for (auto line : juce::StringArray::fromLines (text))
+        {
+            ++lineNumber;
+            auto tokens = juce::StringArray::fromTokens (line.upToFirstOccurrenceOf ("#", false, false), " \t", "");
+            tokens.removeEmptyStrings();
+
+            if (tokens.isEmpty())
+                continue;
+
+            auto fail = [&] (const juce::String& message) { return juce::Result::fail ("line " + juce::String (lineNumber) + ": " + message); };
+
+            if (tokens.size() == 1 && tokens[0].equalsIgnoreCase ("loop"))
+            {
+                newSequence.loop = true;
+                continue;
+            }
+
+            Step step = previous;
+
+            if (tokens[0].equalsIgnoreCase ("off"))
+            {
+                if (tokens.size() != 2)
+                    return fail ("expected off <seconds>");
+
+                step.on = false;
+                step.seconds = tokens[1].getDoubleValue();
+            }
+            else
+            {
+                if (tokens.size() != 5)
+                    return fail ("expected <signal> <freq> <gain> <routing> <seconds>");
+
+                auto isKept = [] (const juce::String& token) { return token == "-"; };
+
+                step.on = true;
+                step.signalType = signalNames().indexOf (tokens[0], true);
+
+                if (! isKept (tokens[1])) step.frequency = tokens[1].getFloatValue();
+                if (! isKept (tokens[2])) step.gainDecibels = tokens[2].getFloatValue();
+                if (! isKept (tokens[3])) step.routing = routingNames().indexOf (tokens[3], true);
+
+                step.seconds = tokens[4].getDoubleValue();
+
+                if (step.signalType < 0)
+                    return fail ("signal must be off or one of " + signalNames().joinIntoString (", "));
+
+                if (step.routing < 0)
+                    return fail ("routing must be one of " + routingNames().joinIntoString (", "));
+
+                if (step.frequency < 20.0f || step.frequency > 21000.0f)
+                    return fail ("freq must be 20 to 21000");
+
+                if (step.gainDecibels < -120.0f || step.gainDecibels > 0.0f)
+                    return fail ("gain must be -120 to 0");
+            }
+
+            if (step.seconds < minStepSeconds || step.seconds > maxStepSeconds)
+                return fail ("seconds must be 0.01 to 3600");
+
+            newSequence.steps.push_back (step);
+            previous = step;
+        }
+
+        if (newSequence.isEmpty())
+            return juce::Result::fail ("no steps");
+
+        sequence = std::move (newSequence);
+        return juce::Result::ok();
+    }
+
+    static juce::Result loadFromFile (const juce::File& file, TestSequence& sequence)
+    {
+        if (! file.existsAsFile())
+            return juce::Result::fail ("couldn't open " + file.getFullPathName());
+
+        return parse (file.loadFileAsString(), sequence);
+    }
+
+    // third octave sine steps from 20Hz to 20kHz at each level in turn, with a gap of silence after each tone
+    static TestSequence makeSteppedTones (const juce::Array<float>& levels, double toneSeconds, double gapSeconds)
+    {
+        TestSequence sequence;
+
+        for (auto level : levels)
+        {
+            for (int band = -17; band <= 13; ++band)
+            {
+                Step tone;
+                tone.frequency = (float) juce::jlimit (20.0, 21000.0, 1000.0 * std::pow (2.0, band / 3.0));
+                tone.gainDecibels = level;
+                tone.seconds = toneSeconds;
+                sequence.steps.push_back (tone);
+
+                if (gapSeconds > 0.0)
+                {
+                    auto gap = tone;
+                    gap.on = false;
+                    gap.seconds = gapSeconds;
+                    sequence.steps.push_back (gap);
+                }
+            }
+        }
+
+        return sequence;
+    }
+
+private:
+
+    static const juce::StringArray& signalNames()
+    {
+        static const juce::StringArray names { "sine", "white", "pink", "sweep", "multisine", "saw", "square", "triangle" };
+        return names;
+    }
+
+    static const juce::StringArray& routingNames()
+    {
+        static const juce::StringArray names { "l", "lr", "r", "custom", "walk" };
+        return names;
+    }
+};
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    WhiteNoise.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "FastMath.h"
+#include "Philox.h"
+
+//Bank of independent white noise streams, one per output channel so L and R are decorrelated.
+//Counter based (Philox4x32, see Philox.h): sample n of channel c is worked out from n, c and the seed alone,
+//so seek can jump to any sample and the output doesn't depend on how it's cut into blocks. Noise is made
+//in chunks of 32 samples, 8 Philox blocks side by side (struct of arrays) which the compiler turns into SIMD.
+//Uniform is -1 to 1 with no DC offset, Gaussian is Box-Muller with a standard deviation of 0.25
+//(-12dBFS rms, samples past full scale are around 1 in 16000)
+
+class WhiteNoiseBank
+{
+public:
+
+    enum class Distribution
+    {
+        uniform,
+        gaussian
+    };
+
+    static constexpr int numLanes = 8;
+    static constexpr int chunkSize = numLanes * 4;
+
+    WhiteNoiseBank()
+    {
+        prepare(1, seed);
+    }
+
+    void prepare(int newNumChannels, std::uint64_t newSeed)
+    {
+        positions.resize((size_t) juce::jmax(newNumChannels, 1));
+        seed = newSeed;
+        reset();
+    }
+
+    // restarts every stream from the seed
+    void reset()
+    {
+        seek(0);
+    }
+
+    // every channel carries on from sample position
+    void seek(std::int64_t position) noexcept
+    {
+        std::fill(positions.begin(), positions.end(), position);
+    }
+
+    int getNumChannels() const noexcept { return (int) positions.size(); }
+
+    void setDistribution(Distribution newDistribution) noexcept { distribution = newDistribution; }
+    Distribution getDistribution() const noexcept { return distribution; }
+
+    void process(int channel, float* dest, int numSamples) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(channel, getNumChannels()));
+        auto& position = positions[(size_t) channel];
+        alignas(32) float values[chunkSize];
+
+        for (int done = 0; done < numSamples;)
+        {
+            auto chunk = position / chunkSize;
+            auto offset = (int) (position - chunk * chunkSize);
+            auto num = juce::jmin(chunkSize - offset, numSamples - done);
+
+            if (offset == 0 && num == chunkSize)
+            {
+                renderChunk(channel, chunk, dest + done);
+            }
+            else
+            {
+                renderChunk(channel, chunk, values);
+                std::copy(values + offset, values + offset + num, dest + done);
+            }
+
+            position += num;
+            done += num;
+        }
+    }
+
+private:
+
+    // 32 samples from chunk on, word w of lane l is sample w * numLanes + l
+    void renderChunk(int channel, std::int64_t chunk, float* dest) const noexcept
+    {
+        alignas(32) std::uint32_t words[4][numLanes];
+
+        for (int l = 0; l < numLanes; ++l)
+        {
+            auto block = (std::uint64_t) chunk * numLanes + (std::uint64_t) l;
+            words[0][l] = (std::uint32_t) block;
+            words[1][l] = (std::uint32_t) (block >> 32);
+            words[2][l] = (std::uint32_t) channel;
+            words[3][l] = 0;
+        }
+
+        Philox4x32::generate<numLanes>(words, (std::uint32_t) seed, (std::uint32_t) (seed >> 32));
+
+        if (distribution == Distribution::uniform)
+        {
+            for (int w = 0; w < 4; ++w)
+                for (int l = 0; l < numLanes; ++l)
+                    dest[w * numLanes + l] = Philox4x32::toBipolar(words[w][l]);
+        }
+        else
+        {
+            constexpr float standardDeviation = 0.25f;
+
+            // words 0 and 1 make one pair of samples, 2 and 3 the other
+            for (int pair = 0; pair < 2; ++pair)
+            {
+                for (int l = 0; l < numLanes; ++l)
+                {
+                    // half a step in from both ends, never 0 for the log and never exactly 1 (log 1 is 0 and the
+                    // radius would be the sqrt of -0)
+                    auto u1 = ((float) (words[pair * 2][l] >> 8) + 0.5f) * (1.0f / 16777216.0f);
+                    auto u2 = (float) (words[pair * 2 + 1][l] >> 8) * (1.0f / 16777216.0f) - 0.5f; // -0.5 to 0.5 cycles
+                    auto radius = standardDeviation * FastMath::sqrt(-2.0f * FastMath::log(u1));
+
+                    dest[(pair * 2) * numLanes + l] = radius * FastMath::sinCycles(u2);
+                    dest[(pair * 2 + 1) * numLanes + l] = radius * FastMath::cosCycles(u2);
+                }
+            }
+        }
+    }
+
+    std::vector<std::int64_t> positions;
+    std::uint64_t seed { 0x5eed5eed5eed5eedull };
+    Distribution distribution { Distribution::uniform };
+};